@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace Bench
+{
+	/// What comparing the two FAP engines found
+	struct EngineCheckSummary
+	{
+		int								battles = 0;
+		int								mismatches = 0;
+
+		/// Index of the first battle that ended differently, -1 if none did. Rerun it with the same seed to debug it
+		int								first_mismatch = -1;
+
+		std::int64_t					frames = 0;
+	};
+
+	/// <summary> Sim count random battles on FastAPproximation and FastAPproximationSoA from the same units and check that they simulate
+	///     the same frames and end in the same state, unit for unit. Battles draw their UnitTypes, army sizes and both players' upgrades
+	///     from stream i of the seed. They run in steps of random length, half of them with the target grid on, so runs split over several
+	///     simulate() calls and grid targeting are checked too </summary>
+	EngineCheckSummary checkEngines(const int count, const std::uint64_t seed);
+
+	/// <summary> Write the summary as a JSON object </summary>
+	void writeEngineCheckJson(std::ostream& out, const std::uint64_t seed, const EngineCheckSummary& summary);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Bench
+{
+	/// What replaying a file of scenario records found
+	struct ReplaySummary
+	{
+		size_t							records = 0;
+		size_t							each = 0;
+		size_t							forces = 0;
+
+		/// Records that couldn't be decoded and were skipped
+		size_t							damaged = 0;
+
+		/// simulateBatch() calls the simulateEach() records were grouped into
+		size_t							batches = 0;
+
+		std::int64_t					sims = 0;
+		std::int64_t					frames = 0;
+		double							seconds = 0;
+
+		/// simulateEach() records whose optimal unit changed
+		size_t							optimal_mismatches = 0;
+
+		/// Largest change of a recorded UnitType's score, over the UnitTypes that were simmed
+		double							max_score_error = 0;
+
+		/// simulateForces() records whose winner or score changed
+		size_t							forces_mismatches = 0;
+
+		/// Recorded prototypes converted again from their UnitType and upgrades, and those that came out different
+		size_t							prototypes_checked = 0;
+		size_t							prototype_mismatches = 0;
+	};
+
+	/// <summary> Run every record of the file again headless with the seed, engine, upgrades and survival rates it was recorded with,
+	///     and compare the results and prototypes to the recorded ones. Consecutive simulateEach() records run with the same settings
+	///     are answered batch_size at a time by one simulateBatch(). Races with a time budget can end differently than they were recorded.
+	///     False if the file can't be read </summary>
+	bool replay(const std::string& path, ReplaySummary& summary, const size_t batch_size = 256);
+
+	/// <summary> Write the summary as a JSON object </summary>
+	void writeReplayJson(std::ostream& out, const std::string& path, const ReplaySummary& summary);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+	/// Timings of one scenario on one engine
+	struct Measurement
+	{
+		std::string						scenario;
+		std::string						engine;
+
+		/// Wall clock time of every timed call
+		std::vector<double>				latencies_us;
+
+		std::int64_t					sims = 0;
+		std::int64_t					frames = 0;
+		std::uint64_t					allocations = 0;
+	};
+
+	/// Settings the measurements were taken with
+	struct RunInfo
+	{
+		int								iterations = 0;
+		unsigned						threads = 0;
+		std::uint64_t					seed = 0;
+	};
+
+	/// <summary> Value below which fraction p of the samples lie, interpolated between the closest two </summary>
+	double percentile(std::vector<double> samples, const double p);
+
+	/// <summary> Write the measurements as a JSON object with throughput, p50/p99 latency and allocations per sim of each </summary>
+	void writeJson(std::ostream& out, const RunInfo& info, const std::vector<Measurement>& measurements);
+}
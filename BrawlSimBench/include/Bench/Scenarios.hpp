@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BWAPI.h"
+
+namespace Bench
+{
+	/// A fight the benchmark times. Kind::Each runs simulateEach() over friendly_types, Kind::Forces runs simulateForces() with friendly_army.
+	/// Kind::Sequential runs a simulateEach() over friendly_types per army of enemy_armies, Kind::Batch asks the same in one simulateBatch()
+	struct Scenario
+	{
+		enum class Kind
+		{
+			Each,
+			Forces,
+			Sequential,
+			Batch
+		};
+
+		std::string						name;
+		Kind							kind = Kind::Each;
+		BWAPI::Race						self_race = BWAPI::Races::Terran;
+		BWAPI::Race						enemy_race = BWAPI::Races::Zerg;
+
+		BWAPI::UnitType::set			friendly_types;
+		std::vector<BWAPI::UnitType>	friendly_army;
+		std::vector<BWAPI::UnitType>	enemy_army;
+		std::vector<std::vector<BWAPI::UnitType>>	enemy_armies;
+
+		/// Monte Carlo trials per call
+		int								sims = 8;
+	};
+
+	/// <summary> One UnitType per unit from (UnitType, count) pairs </summary>
+	std::vector<BWAPI::UnitType> army(const std::vector<std::pair<BWAPI::UnitType, int>>& counts);
+
+	/// <summary> The benchmark corpus. Names are kept stable so reports can be compared between releases </summary>
+	std::vector<Scenario> canonicalScenarios();
+}
@@ -0,0 +1,143 @@
+#include "../../BrawlSimBench/include/Bench/EngineCheck.hpp"
+#include "../../BrawlSimLib/include/BrawlSim.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/OfflineGame.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace Bench
+{
+	namespace
+	{
+		/// The UnitTypes Brawl sims: no workers, buildings, heroes, spells or units that only exist as another unit's attack
+		std::vector<BWAPI::UnitType> combatTypes()
+		{
+			std::vector<BWAPI::UnitType> types;
+			for (const auto& type : BWAPI::UnitTypes::allUnitTypes())
+			{
+				if (type.isWorker() ||
+					type.isHero() ||
+					type.supplyRequired() == 0 ||
+					type == BWAPI::UnitTypes::Terran_Nuclear_Missile ||
+					type == BWAPI::UnitTypes::Protoss_Interceptor ||
+					type == BWAPI::UnitTypes::Protoss_Scarab ||
+					type == BWAPI::UnitTypes::Zerg_Infested_Terran)
+				{
+					continue;
+				}
+				if (type.canAttack() || type == BWAPI::UnitTypes::Terran_Medic)
+				{
+					types.push_back(type);
+				}
+			}
+			return types;
+		}
+
+		/// About a quarter of the upgrades at a random level and a quarter of the techs researched
+		void randomUpgrades(BrawlSim::OfflinePlayer& player, BrawlSim::Rng& rng)
+		{
+			for (int id = 0; id < BWAPI::UpgradeTypes::Enum::MAX; ++id)
+			{
+				const BWAPI::UpgradeType upgrade(id);
+				player.setUpgradeLevel(upgrade, rng.range(0, 3) == 0 ? rng.range(1, std::max(upgrade.maxRepeats(), 1)) : 0);
+			}
+			for (int id = 0; id < BWAPI::TechTypes::Enum::MAX; ++id)
+			{
+				player.setResearched(BWAPI::TechType(id), rng.range(0, 3) == 0);
+			}
+		}
+
+		/// Add up to 60 units of up to 4 UnitTypes to one side of both engines' starting units. data keeps the UnitData the units point at
+		void randomArmy(const std::vector<BWAPI::UnitType>& types, const BWAPI::Player player, BrawlSim::Rng& rng,
+			std::deque<UnitData>& data, std::vector<FAP::FAPUnit<BrawlSim::UnitTag>>& units)
+		{
+			const int kinds = rng.range(1, 4);
+			const int size = rng.range(1, 60);
+			for (int k = 0; k < kinds; ++k)
+			{
+				data.emplace_back(types[rng.range(0, static_cast<int>(types.size()) - 1)], player);
+			}
+			std::vector<FAP::FAPUnit<BrawlSim::UnitTag>> prototypes;
+			for (size_t k = data.size() - kinds; k < data.size(); ++k)
+			{
+				prototypes.push_back(data[k].prototypeFAPUnit());
+			}
+			for (int id = 0; id < size; ++id)
+			{
+				const int k = rng.range(0, kinds - 1);
+				UnitData& unit_data = data[data.size() - kinds + k];
+				auto unit = unit_data.stampFAPUnit(prototypes[k], rng);
+				unit.data = BrawlSim::UnitTag(&unit_data, id);
+				units.push_back(unit);
+			}
+		}
+	}
+
+	EngineCheckSummary checkEngines(const int count, const std::uint64_t seed)
+	{
+		EngineCheckSummary summary;
+		const std::vector<BWAPI::UnitType> types = combatTypes();
+		BrawlSim::OfflineGame game(BWAPI::Races::None, BWAPI::Races::None);
+
+		std::deque<UnitData> data;
+		std::vector<FAP::FAPUnit<BrawlSim::UnitTag>> friendly;
+		std::vector<FAP::FAPUnit<BrawlSim::UnitTag>> enemy;
+		for (int i = 0; i < count; ++i)
+		{
+			BrawlSim::Rng rng(seed, i);
+			randomUpgrades(*game.self(), rng);
+			randomUpgrades(*game.enemy(), rng);
+
+			data.clear();
+			friendly.clear();
+			enemy.clear();
+			randomArmy(types, game.self(), rng, data, friendly);
+			randomArmy(types, game.enemy(), rng, data, enemy);
+
+			FAP::FastAPproximation<BrawlSim::UnitTag> aos;
+			FAP::FastAPproximationSoA<BrawlSim::UnitTag> soa;
+			aos.setTargetGrid(rng.range(0, 1) ? 8 : 0);
+			aos.setUnitsPlayer1(friendly);
+			aos.setUnitsPlayer2(enemy);
+			soa.setUnitsPlayer1(friendly);
+			soa.setUnitsPlayer2(enemy);
+
+			bool same = true;
+			int left = rng.range(1, 4 * BrawlSim::TrialSims::trial_frames);
+			while (same && left > 0)
+			{
+				const int step = std::min(rng.range(1, 48), left);
+				const int aos_frames = aos.simulate(step);
+				same = aos_frames == soa.simulate(step);
+				summary.frames += aos_frames;
+				left = aos_frames < step ? 0 : left - step;
+			}
+			const auto state = soa.getState();
+			same = same && FAP::sameUnits(*aos.getState().first, *state.first) && FAP::sameUnits(*aos.getState().second, *state.second);
+
+			++summary.battles;
+			if (!same)
+			{
+				++summary.mismatches;
+				if (summary.first_mismatch < 0)
+				{
+					summary.first_mismatch = i;
+				}
+			}
+		}
+		return summary;
+	}
+
+	void writeEngineCheckJson(std::ostream& out, const std::uint64_t seed, const EngineCheckSummary& summary)
+	{
+		out << "{\n";
+		out << "  \"seed\": " << seed << ",\n";
+		out << "  \"battles\": " << summary.battles << ",\n";
+		out << "  \"frames\": " << summary.frames << ",\n";
+		out << "  \"mismatches\": " << summary.mismatches << ",\n";
+		out << "  \"first_mismatch\": " << summary.first_mismatch << "\n";
+		out << "}\n";
+	}
+}
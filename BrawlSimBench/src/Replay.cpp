@@ -0,0 +1,266 @@
+#include "../../BrawlSimBench/include/Bench/Replay.hpp"
+#include "../../BrawlSimLib/include/BrawlSim.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/OfflineGame.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace Bench
+{
+	namespace
+	{
+		bool samePlayer(const BrawlSim::ScenarioPlayer& lhs, const BrawlSim::ScenarioPlayer& rhs)
+		{
+			return lhs.upgrades == rhs.upgrades && lhs.techs == rhs.techs;
+		}
+
+		/// Give the player the recorded upgrades and techs and no others
+		void applyPlayer(BrawlSim::OfflinePlayer& player, const BrawlSim::ScenarioPlayer& recorded)
+		{
+			for (int id = 0; id < BWAPI::UpgradeTypes::Enum::MAX; ++id)
+			{
+				player.setUpgradeLevel(BWAPI::UpgradeType(id), 0);
+			}
+			for (int id = 0; id < BWAPI::TechTypes::Enum::MAX; ++id)
+			{
+				player.setResearched(BWAPI::TechType(id), false);
+			}
+			for (const auto& upgrade : recorded.upgrades)
+			{
+				player.setUpgradeLevel(BWAPI::UpgradeType(upgrade.first), upgrade.second);
+			}
+			for (const int tech : recorded.techs)
+			{
+				player.setResearched(BWAPI::TechType(tech));
+			}
+		}
+
+		/// Every field of a prototype a scenario record keeps
+		bool sameUnit(const FAP::FAPUnit<BrawlSim::UnitTag>& lhs, const FAP::FAPUnit<BrawlSim::UnitTag>& rhs)
+		{
+			return lhs.x == rhs.x && lhs.y == rhs.y
+				&& lhs.health == rhs.health && lhs.maxHealth == rhs.maxHealth && lhs.armor == rhs.armor
+				&& lhs.shields == rhs.shields && lhs.maxShields == rhs.maxShields && lhs.shieldArmor == rhs.shieldArmor
+				&& lhs.speed == rhs.speed && lhs.speedSquared == rhs.speedSquared
+				&& lhs.flying == rhs.flying && lhs.elevation == rhs.elevation
+				&& lhs.groundDamage == rhs.groundDamage && lhs.groundCooldown == rhs.groundCooldown
+				&& lhs.groundMaxRangeSquared == rhs.groundMaxRangeSquared && lhs.groundMinRangeSquared == rhs.groundMinRangeSquared
+				&& lhs.groundDamageType == rhs.groundDamageType
+				&& lhs.airDamage == rhs.airDamage && lhs.airCooldown == rhs.airCooldown
+				&& lhs.airMaxRangeSquared == rhs.airMaxRangeSquared && lhs.airMinRangeSquared == rhs.airMinRangeSquared
+				&& lhs.airDamageType == rhs.airDamageType
+				&& lhs.unitType == rhs.unitType && lhs.unitSize == rhs.unitSize && lhs.isOrganic == rhs.isOrganic
+				&& lhs.numAttackers == rhs.numAttackers && lhs.attackCooldownRemaining == rhs.attackCooldownRemaining;
+		}
+
+		/// Runs the records in the order they were written. The game and Brawl are only set up again when a record's settings differ
+		/// from the last one's, so the simulateEach() records in between are queued and answered together
+		class Replayer
+		{
+		public:
+			Replayer(ReplaySummary& replay_summary, const size_t batch_size)
+				: summary(replay_summary)
+				, batch_limit(std::max<size_t>(batch_size, 1))
+			{
+			}
+
+			void run(const BrawlSim::Scenario& scenario)
+			{
+				++summary.records;
+
+				BrawlSim::SurvivalRates wanted = rates;
+				for (const auto& prototype : scenario.prototypes)
+				{
+					wanted[prototype.unit.unitType.getID()] = prototype.survival_rate;
+				}
+				if (!configured || scenario.seed != seed || scenario.engine != engine || wanted != rates
+					|| !samePlayer(scenario.players[0], players[0]) || !samePlayer(scenario.players[1], players[1]))
+				{
+					flush();
+					configure(scenario, wanted);
+				}
+				checkPrototypes(scenario);
+
+				if (scenario.kind == BrawlSim::Scenario::Kind::Each)
+				{
+					++summary.each;
+					BrawlSim::EachQuery query;
+					query.friendly_types.insert(scenario.friendly_types.begin(), scenario.friendly_types.end());
+					query.enemy_types = scenario.enemy_types;
+					query.budget = scenario.budget;
+					query.scoring_type = scenario.scoring_type;
+					query.army_size = scenario.army_size;
+					queries.push_back(query);
+					expected.push_back(std::make_pair(scenario.ranks, scenario.optimal_unit));
+					if (queries.size() >= batch_limit)
+					{
+						flush();
+					}
+				}
+				else
+				{
+					++summary.forces;
+					brawl.simulateForces(scenario.friendly_types, scenario.enemy_types, scenario.trials);
+					summary.sims += brawl.getSimCount();
+					summary.frames += brawl.getFrameCount();
+
+					// Same winner and score as getBestForce() of the recorded call
+					const bool won = scenario.friendly_score >= scenario.enemy_score;
+					const int score = scenario.friendly_score > scenario.enemy_score ? scenario.friendly_score
+						: scenario.friendly_score < scenario.enemy_score ? scenario.enemy_score : 0;
+					const auto best = brawl.getBestForce();
+					summary.forces_mismatches += (best.first == game.self()) != won || best.second != score;
+				}
+			}
+
+			/// Answer the queued simulateEach() records in one simulateBatch()
+			void flush()
+			{
+				if (queries.empty())
+				{
+					return;
+				}
+				brawl.simulateBatch(queries, results);
+				++summary.batches;
+
+				for (size_t i = 0; i < queries.size(); ++i)
+				{
+					const BrawlSim::EachResult& result = results[i];
+					summary.sims += result.sims;
+					summary.frames += result.frames;
+					summary.optimal_mismatches += result.optimal_unit != expected[i].second;
+
+					for (const auto& recorded : expected[i].first)
+					{
+						if (recorded.sims == 0)
+						{
+							continue;
+						}
+						const auto rank = std::find_if(result.ranks.begin(), result.ranks.end(), [&](const BrawlSim::UnitRank& r)
+						{
+							return r.type == recorded.type;
+						});
+						if (rank != result.ranks.end())
+						{
+							summary.max_score_error = std::max(summary.max_score_error, std::abs(rank->score - recorded.score));
+						}
+					}
+				}
+				queries.clear();
+				expected.clear();
+			}
+
+		private:
+			ReplaySummary&									summary;
+			const size_t									batch_limit;
+
+			BrawlSim::OfflineGame							game{ BWAPI::Races::None, BWAPI::Races::None };
+			BrawlSim::Brawl									brawl{ game };
+
+			/// Settings applied to the game and Brawl
+			bool											configured = false;
+			std::uint64_t									seed = 0;
+			BrawlSim::SimEngine								engine = BrawlSim::SimEngine::ArrayOfStructs;
+			std::array<BrawlSim::ScenarioPlayer, 2>			players;
+			BrawlSim::SurvivalRates							rates = BrawlSim::default_survival_rates;
+
+			/// Side and UnitType ID of the prototypes checked since the settings were applied
+			std::set<std::pair<int, int>>					checked;
+
+			std::vector<BrawlSim::EachQuery>				queries;
+			std::vector<BrawlSim::EachResult>				results;
+			std::vector<std::pair<std::vector<BrawlSim::UnitRank>, BWAPI::UnitType>>	expected;
+
+			void configure(const BrawlSim::Scenario& scenario, const BrawlSim::SurvivalRates& wanted)
+			{
+				applyPlayer(*game.self(), scenario.players[0]);
+				applyPlayer(*game.enemy(), scenario.players[1]);
+				brawl.setSeed(scenario.seed);
+				brawl.setEngine(scenario.engine);
+				if (wanted != rates)
+				{
+					rates = wanted;
+					brawl.setSurvivalRates(rates);
+				}
+
+				configured = true;
+				seed = scenario.seed;
+				engine = scenario.engine;
+				players = scenario.players;
+				checked.clear();
+			}
+
+			/// Convert each recorded prototype again, once per side and UnitType for the same settings
+			void checkPrototypes(const BrawlSim::Scenario& scenario)
+			{
+				for (const auto& recorded : scenario.prototypes)
+				{
+					if (!checked.insert(std::make_pair(recorded.side, recorded.unit.unitType.getID())).second)
+					{
+						continue;
+					}
+					const UnitData data(recorded.unit.unitType, recorded.side == 0 ? game.self() : game.enemy(), rates);
+					++summary.prototypes_checked;
+					summary.prototype_mismatches += !sameUnit(data.prototypeFAPUnit(), recorded.unit)
+						|| data.eco_score != recorded.eco_score || data.top_speed != recorded.top_speed;
+				}
+			}
+		};
+	}
+
+	bool replay(const std::string& path, ReplaySummary& summary, const size_t batch_size)
+	{
+		summary = ReplaySummary();
+		BrawlSim::ScenarioReader reader;
+		if (!reader.open(path))
+		{
+			return false;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		Replayer replayer(summary, batch_size);
+		BrawlSim::Scenario scenario;
+		for (size_t i = 0; i < reader.size(); ++i)
+		{
+			if (reader.read(i, scenario))
+			{
+				replayer.run(scenario);
+			}
+			else
+			{
+				++summary.damaged;
+			}
+		}
+		replayer.flush();
+		summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return true;
+	}
+
+	void writeReplayJson(std::ostream& out, const std::string& path, const ReplaySummary& summary)
+	{
+		out << "{\n";
+		out << "  \"file\": \"" << path << "\",\n";
+		out << "  \"records\": " << summary.records << ",\n";
+		out << "  \"each\": " << summary.each << ",\n";
+		out << "  \"forces\": " << summary.forces << ",\n";
+		out << "  \"damaged\": " << summary.damaged << ",\n";
+		out << "  \"batches\": " << summary.batches << ",\n";
+		out << "  \"sims\": " << summary.sims << ",\n";
+		out << "  \"frames\": " << summary.frames << ",\n";
+		out << "  \"seconds\": " << summary.seconds << ",\n";
+		out << "  \"records_per_sec\": " << (summary.seconds > 0 ? summary.records / summary.seconds : 0) << ",\n";
+		out << "  \"sims_per_sec\": " << (summary.seconds > 0 ? summary.sims / summary.seconds : 0) << ",\n";
+		out << "  \"optimal_mismatches\": " << summary.optimal_mismatches << ",\n";
+		out << "  \"max_score_error\": " << summary.max_score_error << ",\n";
+		out << "  \"forces_mismatches\": " << summary.forces_mismatches << ",\n";
+		out << "  \"prototypes_checked\": " << summary.prototypes_checked << ",\n";
+		out << "  \"prototype_mismatches\": " << summary.prototype_mismatches << "\n";
+		out << "}\n";
+	}
+}
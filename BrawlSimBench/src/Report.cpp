@@ -0,0 +1,54 @@
+#include "../../BrawlSimBench/include/Bench/Report.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Bench
+{
+	double percentile(std::vector<double> samples, const double p)
+	{
+		if (samples.empty())
+		{
+			return 0;
+		}
+		std::sort(samples.begin(), samples.end());
+		const double rank = p * (samples.size() - 1);
+		const size_t low = static_cast<size_t>(rank);
+		const size_t high = std::min(low + 1, samples.size() - 1);
+		return samples[low] + (rank - low) * (samples[high] - samples[low]);
+	}
+
+	void writeJson(std::ostream& out, const RunInfo& info, const std::vector<Measurement>& measurements)
+	{
+		out << "{\n";
+		out << "  \"iterations\": " << info.iterations << ",\n";
+		out << "  \"threads\": " << info.threads << ",\n";
+		out << "  \"seed\": " << info.seed << ",\n";
+		out << "  \"results\": [";
+
+		for (size_t i = 0; i < measurements.size(); ++i)
+		{
+			const Measurement& m = measurements[i];
+			const double seconds = std::accumulate(m.latencies_us.begin(), m.latencies_us.end(), 0.0) / 1e6;
+			const double calls = static_cast<double>(std::max<size_t>(m.latencies_us.size(), 1));
+
+			out << (i ? ",\n" : "\n");
+			out << "    {\n";
+			out << "      \"scenario\": \"" << m.scenario << "\",\n";
+			out << "      \"engine\": \"" << m.engine << "\",\n";
+			out << "      \"calls\": " << m.latencies_us.size() << ",\n";
+			out << "      \"sims\": " << m.sims << ",\n";
+			out << "      \"frames\": " << m.frames << ",\n";
+			out << "      \"sims_per_sec\": " << (seconds > 0 ? m.sims / seconds : 0) << ",\n";
+			out << "      \"frames_per_sec\": " << (seconds > 0 ? m.frames / seconds : 0) << ",\n";
+			out << "      \"mean_us\": " << seconds * 1e6 / calls << ",\n";
+			out << "      \"p50_us\": " << percentile(m.latencies_us, 0.5) << ",\n";
+			out << "      \"p99_us\": " << percentile(m.latencies_us, 0.99) << ",\n";
+			out << "      \"allocations_per_call\": " << m.allocations / calls << ",\n";
+			out << "      \"allocations_per_sim\": " << (m.sims ? static_cast<double>(m.allocations) / m.sims : 0) << "\n";
+			out << "    }";
+		}
+
+		out << "\n  ]\n}\n";
+	}
+}
@@ -0,0 +1,84 @@
+#include "../../BrawlSimBench/include/Bench/Scenarios.hpp"
+
+namespace Bench
+{
+	std::vector<BWAPI::UnitType> army(const std::vector<std::pair<BWAPI::UnitType, int>>& counts)
+	{
+		std::vector<BWAPI::UnitType> units;
+		for (const auto& c : counts)
+		{
+			units.insert(units.end(), c.second, c.first);
+		}
+		return units;
+	}
+
+	std::vector<Scenario> canonicalScenarios()
+	{
+		using namespace BWAPI::UnitTypes;
+		std::vector<Scenario> scenarios;
+
+		Scenario skirmish;
+		skirmish.name = "skirmish_each";
+		skirmish.friendly_types = { Terran_Marine, Terran_Firebat, Terran_Vulture };
+		skirmish.enemy_army = army({ { Zerg_Zergling, 8 }, { Zerg_Hydralisk, 4 } });
+		scenarios.push_back(skirmish);
+
+		Scenario sweep;
+		sweep.name = "sweep_12_types_each";
+		sweep.friendly_types = {
+			Terran_Marine, Terran_Firebat, Terran_Medic, Terran_Ghost,
+			Terran_Vulture, Terran_Goliath, Terran_Siege_Tank_Tank_Mode, Terran_Siege_Tank_Siege_Mode,
+			Terran_Wraith, Terran_Valkyrie, Terran_Battlecruiser, Protoss_Dragoon };
+		sweep.enemy_army = army({ { Zerg_Zergling, 16 }, { Zerg_Hydralisk, 12 }, { Zerg_Mutalisk, 6 }, { Zerg_Lurker, 2 } });
+		scenarios.push_back(sweep);
+
+		Scenario large;
+		large.name = "forces_100v100";
+		large.kind = Scenario::Kind::Forces;
+		large.friendly_army = army({ { Terran_Marine, 60 }, { Terran_Medic, 15 }, { Terran_Siege_Tank_Tank_Mode, 15 }, { Terran_Goliath, 10 } });
+		large.enemy_army = army({ { Zerg_Zergling, 50 }, { Zerg_Hydralisk, 35 }, { Zerg_Mutalisk, 15 } });
+		scenarios.push_back(large);
+
+		Scenario splash;
+		splash.name = "forces_splash_tanks";
+		splash.kind = Scenario::Kind::Forces;
+		splash.enemy_race = BWAPI::Races::Protoss;
+		splash.friendly_army = army({ { Terran_Siege_Tank_Siege_Mode, 16 }, { Terran_Vulture, 12 }, { Terran_Firebat, 8 } });
+		splash.enemy_army = army({ { Protoss_Zealot, 30 }, { Protoss_Dragoon, 20 }, { Protoss_Archon, 4 } });
+		scenarios.push_back(splash);
+
+		// Carriers and Reavers fight through interceptors and scarabs. The Bunker has no supply, so Brawl leaves it out of the sim
+		Scenario edge;
+		edge.name = "forces_carrier_reaver_bunker";
+		edge.kind = Scenario::Kind::Forces;
+		edge.self_race = BWAPI::Races::Protoss;
+		edge.enemy_race = BWAPI::Races::Terran;
+		edge.friendly_army = army({ { Protoss_Carrier, 6 }, { Protoss_Reaver, 4 }, { Protoss_Shuttle, 2 } });
+		edge.enemy_army = army({ { Terran_Marine, 24 }, { Terran_Goliath, 8 }, { Terran_Bunker, 2 } });
+		scenarios.push_back(edge);
+
+		Scenario heals;
+		heals.name = "forces_medic_heals";
+		heals.kind = Scenario::Kind::Forces;
+		heals.friendly_army = army({ { Terran_Marine, 24 }, { Terran_Medic, 8 } });
+		heals.enemy_army = army({ { Zerg_Zergling, 36 }, { Zerg_Hydralisk, 8 } });
+		scenarios.push_back(heals);
+
+		// The questions a bot asks in one frame: the army at the natural, the army at a third and the army expected later
+		Scenario fronts;
+		fronts.name = "fronts_sequential";
+		fronts.kind = Scenario::Kind::Sequential;
+		fronts.friendly_types = { Terran_Marine, Terran_Firebat, Terran_Vulture, Terran_Goliath, Terran_Siege_Tank_Tank_Mode, Terran_Wraith };
+		fronts.enemy_armies = {
+			army({ { Zerg_Zergling, 12 }, { Zerg_Hydralisk, 6 } }),
+			army({ { Zerg_Mutalisk, 8 }, { Zerg_Scourge, 6 } }),
+			army({ { Zerg_Hydralisk, 16 }, { Zerg_Lurker, 4 }, { Zerg_Ultralisk, 2 } }) };
+		scenarios.push_back(fronts);
+
+		fronts.name = "fronts_batch";
+		fronts.kind = Scenario::Kind::Batch;
+		scenarios.push_back(fronts);
+
+		return scenarios;
+	}
+}
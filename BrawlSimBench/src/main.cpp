@@ -0,0 +1,180 @@
+#include "../../BrawlSimLib/include/BrawlSim.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/OfflineGame.hpp"
+#include "../../BrawlSimBench/include/Bench/Scenarios.hpp"
+#include "../../BrawlSimBench/include/Bench/Report.hpp"
+#include "../../BrawlSimBench/include/Bench/Replay.hpp"
+#include "../../BrawlSimBench/include/Bench/EngineCheck.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+/// Every heap allocation of the process, counted by the replaced global operator new
+static std::atomic<std::uint64_t> allocation_count{ 0 };
+
+void* operator new(std::size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	const std::uint64_t bench_seed = 0x5EED;
+
+	/// Queries and results of a Kind::Batch scenario, built once so the timed calls only simulate
+	struct Batch
+	{
+		std::vector<BrawlSim::EachQuery>	queries;
+		std::vector<BrawlSim::EachResult>	results;
+	};
+
+	Batch makeBatch(const Bench::Scenario& scenario)
+	{
+		Batch batch;
+		for (const auto& enemy_army : scenario.enemy_armies)
+		{
+			BrawlSim::EachQuery query;
+			query.friendly_types = scenario.friendly_types;
+			query.enemy_types = enemy_army;
+			query.budget = BrawlSim::SimBudget::fixed(scenario.sims);
+			batch.queries.push_back(query);
+		}
+		return batch;
+	}
+
+	/// Run the scenario once and return the sims and frames it took
+	std::pair<std::int64_t, std::int64_t> runScenario(BrawlSim::Brawl& brawl, const Bench::Scenario& scenario, Batch& batch)
+	{
+		switch (scenario.kind)
+		{
+		case Bench::Scenario::Kind::Each:
+			brawl.simulateEach(scenario.friendly_types, scenario.enemy_army, 0, -1, scenario.sims);
+			break;
+		case Bench::Scenario::Kind::Forces:
+			brawl.simulateForces(scenario.friendly_army, scenario.enemy_army, scenario.sims);
+			break;
+		case Bench::Scenario::Kind::Sequential:
+		{
+			std::pair<std::int64_t, std::int64_t> total(0, 0);
+			for (const auto& enemy_army : scenario.enemy_armies)
+			{
+				brawl.simulateEach(scenario.friendly_types, enemy_army, 0, -1, scenario.sims);
+				total.first += brawl.getSimCount();
+				total.second += brawl.getFrameCount();
+			}
+			return total;
+		}
+		case Bench::Scenario::Kind::Batch:
+			brawl.simulateBatch(batch.queries, batch.results);
+			break;
+		}
+		return std::make_pair(std::int64_t(brawl.getSimCount()), brawl.getFrameCount());
+	}
+
+	Bench::Measurement measure(const Bench::Scenario& scenario, const BrawlSim::SimEngine engine, const int iterations)
+	{
+		BrawlSim::OfflineGame game(scenario.self_race, scenario.enemy_race);
+		BrawlSim::Brawl brawl(game);
+		brawl.setSeed(bench_seed);
+		brawl.setEngine(engine);
+
+		Bench::Measurement m;
+		m.scenario = scenario.name;
+		m.engine = engine == BrawlSim::SimEngine::ArrayOfStructs ? "aos" : "soa";
+		m.latencies_us.reserve(iterations);
+
+		Batch batch = makeBatch(scenario);
+
+		// Warm up the prototype cache, trial sims and thread pool
+		runScenario(brawl, scenario, batch);
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			const std::uint64_t allocations = allocation_count.load();
+			const auto start = std::chrono::steady_clock::now();
+			const auto counts = runScenario(brawl, scenario, batch);
+			const auto end = std::chrono::steady_clock::now();
+
+			m.allocations += allocation_count.load() - allocations;
+			m.latencies_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+			m.sims += counts.first;
+			m.frames += counts.second;
+		}
+		return m;
+	}
+}
+
+/// BrawlSimBench [iterations] [output.json]
+/// Times the canonical scenarios on both engines headless and writes a JSON report to the file, or to stdout without one
+/// BrawlSimBench --replay scenarios.brsc [output.json]
+/// Runs the records of a file written through Brawl::setRecorder() again and reports what changed since they were recorded
+/// BrawlSimBench --check-engines [battles]
+/// Sims random battles on both FAP engines, reports whether they ended the same and fails if any didn't
+int main(int argc, char** argv)
+{
+	if (argc > 1 && std::string(argv[1]) == "--check-engines")
+	{
+		const Bench::EngineCheckSummary summary = Bench::checkEngines(argc > 2 ? std::max(std::atoi(argv[2]), 1) : 1000, bench_seed);
+		Bench::writeEngineCheckJson(std::cout, bench_seed, summary);
+		return summary.mismatches ? 1 : 0;
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "--replay")
+	{
+		Bench::ReplaySummary summary;
+		if (argc < 3 || !Bench::replay(argv[2], summary))
+		{
+			std::cerr << "Can't read scenario records " << (argc < 3 ? "" : argv[2]) << "\n";
+			return 1;
+		}
+		if (argc > 3)
+		{
+			std::ofstream out(argv[3]);
+			Bench::writeReplayJson(out, argv[2], summary);
+			return out ? 0 : 1;
+		}
+		Bench::writeReplayJson(std::cout, argv[2], summary);
+		return 0;
+	}
+
+	Bench::RunInfo info;
+	info.iterations = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 50;
+	info.threads = std::thread::hardware_concurrency();
+	info.seed = bench_seed;
+
+	std::vector<Bench::Measurement> measurements;
+	for (const auto& scenario : Bench::canonicalScenarios())
+	{
+		for (const auto engine : { BrawlSim::SimEngine::ArrayOfStructs, BrawlSim::SimEngine::StructOfArrays })
+		{
+			measurements.push_back(measure(scenario, engine, info.iterations));
+		}
+	}
+
+	if (argc > 2)
+	{
+		std::ofstream out(argv[2]);
+		Bench::writeJson(out, info, measurements);
+		return out ? 0 : 1;
+	}
+	Bench::writeJson(std::cout, info, measurements);
+	return 0;
+}
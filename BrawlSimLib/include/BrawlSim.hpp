@@ -1,14 +1,41 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <numeric>
 #include <set>
 
 #include "BWAPI.h"
 #include "FAP.hpp"
+#include "FAPSoA.hpp"
 
-#include "BrawlSim\UnitData.hpp"
+#include "BrawlSim/Random.hpp"
+#include "BrawlSim/UnitTag.hpp"
+#include "BrawlSim/UnitStats.hpp"
+#include "BrawlSim/UnitData.hpp"
+#include "BrawlSim/UnitRank.hpp"
+#include "BrawlSim/UnitOutcome.hpp"
+#include "BrawlSim/SimBudget.hpp"
+#include "BrawlSim/EnemyComposition.hpp"
+#include "BrawlSim/ThreadPool.hpp"
+#include "BrawlSim/PrototypeCache.hpp"
+#include "BrawlSim/Timeline.hpp"
+#include "BrawlSim/TrialSims.hpp"
+#include "BrawlSim/Race.hpp"
+#include "BrawlSim/AsyncRace.hpp"
+#include "BrawlSim/RaceBatch.hpp"
+#include "BrawlSim/Lanchester.hpp"
+#include "BrawlSim/CompositionSearch.hpp"
+#include "BrawlSim/ResultCache.hpp"
+#include "BrawlSim/ScenarioRecord.hpp"
+#include "BrawlSim/GameContext.hpp"
+#include "BrawlSim/SimProfile.hpp"
 
 class UnitData;
 
@@ -17,6 +44,12 @@ namespace BrawlSim
 	class Brawl
 	{
 	public:
+		/// <summary> Sims the players of the running BWAPI::Broodwar game </summary>
+		Brawl();
+
+		/// <summary> Sims the players of game_context instead, such as an OfflineGame to run without Brood War </summary>
+		explicit Brawl(GameContext& game_context);
+
 		/// <summary>FAP simulates each friendly UnitType against the composition of enemy Units/UnitTypes
 		///     using Monte Carlo sim positions</summary>
 		/// Checks to make sure units/unittypes are valid simulation units.
@@ -35,12 +68,135 @@ namespace BrawlSim
 		///		Approximate number of units for each force's army composition in the sim. Default -1 for no scaling.
 		/// </param>
 		/// <param name = "sims">
-		///		Number of sims to perform for each UnitType. Default 1.
+		///		Number of Monte Carlo trials to perform for each UnitType. Trials are run in parallel. Default 1.
 		/// </param>
 		void simulateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const int scoring_type = 0, int army_size = -1, const int sims = 1);
 
+		/// @Overload
+		/// <summary>Races the friendly UnitTypes against each other within a trial budget instead of running the same number of trials for each.
+		///     A UnitType stops being simmed once its score interval is clearly below the leader's, so most of the budget goes to the close contenders.</summary>
+		///
+		/// <param name = "budget">
+		///		Total trials and/or microseconds for the whole call, the trials each UnitType runs before it can be dropped, and the interval width.
+		/// </param>
+		void simulateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// @Overload
+		/// <summary>Same sims against an enemy army given as one UnitType per unit, which doesn't need units of a running game</summary>
+		void simulateEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const int scoring_type = 0, int army_size = -1, const int sims = 1);
+		void simulateEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// <summary>Runs simulateEach() with the pre-screen of SimBudget::prune_below off and compares the Lanchester estimate of every raced
+		///     UnitType to its FAP score, to tune prune_below against the armies a bot meets</summary>
+		PrescreenReport reportPrescreen(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// <summary>Starts the same race as simulateEach() with a SimBudget, but doesn't run any trials. Run it with step() over as many game frames as needed.
+		///     Replaces a job that hasn't finished. The units are converted now, so later changes to the game don't affect the job.</summary>
+		void startEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+		void startEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// <summary>Starts a race like startEach() that carries over the trials of the last finished simulateEach(), startEach() or startUpdate() race,
+		///     for when the enemy composition changed by a few units. Each UnitType keeps its earlier trials, weighted by the share of the scaled
+		///     enemy composition that is unchanged. UnitTypes already clearly behind the leader get no new trials, the others are brought up to
+		///     the budget's min_sims with at least one new trial each, then raced as usual. Nothing is carried over if scoring_type, army_size,
+		///     the seed or the upgrades changed. Updates skip the result cache.</summary>
+		void startUpdate(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+		void startUpdate(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// <summary> Runs the race of startUpdate() to its end, like simulateEach() does for startEach() </summary>
+		void updateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+		void updateEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// <summary>Advances the job started by startEach() by at most the given time and/or FAP frames, then returns true if it is done.
+		///     While it runs, getUnitRanks() and getOptimalUnit() hold the ranks of the trials finished so far.</summary>
+		bool step(const StepBudget& step_budget = StepBudget());
+
+		/// <summary> True unless a job started by startEach() still has trials to run </summary>
+		bool isDone() const;
+
+		/// <summary>Starts the same race as startEach() on a background thread and returns without running any trials.
+		///     The units are converted now on the game thread, the background thread never calls BWAPI.
+		///     Replaces a background race that hasn't finished. Take its ranks with pollAsync().</summary>
+		void startAsync(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+		void startAsync(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type = 0, int army_size = -1);
+
+		/// <summary>Takes the latest ranks of the background race without waiting for it, then returns true if they changed.
+		///     getUnitRanks(), getOptimalUnit() and the draw functions show them until the next sim call.</summary>
+		bool pollAsync();
+
+		/// <summary> True unless the background race started by startAsync() still has trials to run, as of the last pollAsync() </summary>
+		bool isAsyncDone() const;
+
+		/// <summary>Answers several simulateEach() queries in one call, results[i] for queries[i].
+		///     Prototypes are converted once for every query and the trials of all of them share the thread pool,
+		///     so it is faster than a simulateEach() per query. Like any sim call it clears the results of the last one and drops a job started
+		///     by startEach(), so getUnitRanks(), getOptimalUnit() and the draw functions have nothing to show until the next simulateEach().
+		///     getSimCount(), getFrameCount() and getProfile() count the whole batch.</summary>
+		void simulateBatch(const std::vector<EachQuery>& queries, std::vector<EachResult>& results);
+
+		/// <summary>Searches mixes of the friendly UnitTypes that fit in budget for the army that does best against the enemy units, unscaled.
+		///     Mixes are grown a step of one UnitType at a time, keeping the options.beam_width best after each step, and the best one found is
+		///     then improved by trading a step of one UnitType for another. Every mix is FAP simmed in options.trials Monte Carlo trials
+		///     and the mixes of a step share the thread pool. Take the army with getComposition().</summary>
+		void searchComposition(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const ArmyBudget& budget, const CompositionOptions& options = CompositionOptions());
+		void searchComposition(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const ArmyBudget& budget, const CompositionOptions& options = CompositionOptions());
+
+		/// <summary> Best army of the last searchComposition() </summary>
+		const CompositionResult& getComposition() const;
+
+		/// <summary>Finds for each friendly UnitType the fewest units that beat the enemy units, scaled to army_size if it isn't -1.
+		///     Starts from the army that matches the enemy's eco score, doubles it until it wins and then halves the interval to the last
+		///     army that lost, so it takes a logarithmic number of army sizes. Every size is simmed against the same enemy positions
+		///     and the sizes of every UnitType in a round share the thread pool. Take the counts with getBreakEven().</summary>
+		void findBreakEven(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const BreakEvenOptions& options = BreakEvenOptions(), int army_size = -1);
+		void findBreakEven(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const BreakEvenOptions& options = BreakEvenOptions(), int army_size = -1);
+
+		/// <summary> Army sizes found by the last findBreakEven(), in the order of friendly_types. UnitTypes that can't attack the enemy are left out </summary>
+		const std::vector<BreakEven>& getBreakEven() const;
+
+		/// <summary>FAP simulates an entire friendly force against an entire enemy force</summary>
+		/// The remaining force scores are averaged over every trial.
+		///
+		/// <param name = "sims">
+		///		Number of Monte Carlo trials to perform. Trials are run in parallel. Default 1.
+		/// </param>
 		void simulateForces(const BWAPI::Unitset& friendly_units, const BWAPI::Unitset& enemy_units, const int sims = 1);
 
+		/// @Overload
+		/// <summary>Same sim with both forces given as one UnitType per unit</summary>
+		void simulateForces(const std::vector<BWAPI::UnitType>& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const int sims = 1);
+
+		/// <summary> Set the seed of the Monte Carlo sim positions. Trial n of every sim draws from stream n of the seed,
+		///     so results are reproducible and each UnitType is simmed against the same enemy positions.</summary>
+		void setSeed(const std::uint64_t new_seed);
+
+		/// <summary> Set the FAP backend used by the following sims. Default is SimEngine::ArrayOfStructs.
+		///     Define BRAWLSIM_VERIFY_ENGINES to run every StructOfArrays trial on both backends and assert they agree.
+		///     BrawlSimBench --check-engines compares the backends on random battles.</summary>
+		void setEngine(const SimEngine new_engine);
+
+		/// <summary> ArrayOfStructs sims find targets through a spatial grid once the enemy side has at least min_units units.
+		///     Gives the same results, only faster for large battles. 0 always scans every enemy unit. Default is 100.</summary>
+		void setTargetGrid(const int min_units);
+
+		/// <summary> Replace the survival rates scoring type 0 starts each UnitType's score at, indexed by UnitType ID.
+		///     Default is BrawlSim::default_survival_rates. Every cached prototype is rebuilt on the next sim.</summary>
+		void setSurvivalRates(const SurvivalRates& rates);
+
+		/// <summary> Keep the results of up to capacity simulateEach(), startEach() and simulateForces() calls and reuse them for
+		///     max_age_frames game frames, or forever if negative. A call is answered from the cache when the friendly UnitTypes,
+		///     the scaled enemy composition, the budget, scoring_type, army_size, seed and both players' upgrades match.
+		///     No sims are run for a cached answer, so getSimCount() is 0. A capacity of 0, the default, turns the cache off.</summary>
+		void setResultCache(const int capacity, const int max_age_frames = 24 * 5);
+
+		/// <summary> Hits and misses of the result cache since setResultCache() </summary>
+		CacheStats getCacheStats() const;
+
+		/// <summary> Record every simulateEach() and startEach() race once it is done, and every simulateForces(), to writer.
+		///     A record holds the call's arguments, both players' upgrades, the seed, the prototypes the sims copied and the results,
+		///     so it can be replayed headless. Answers from the result cache and startUpdate() races aren't recorded. nullptr, the default, stops recording.</summary>
+		void setRecorder(ScenarioWriter* writer);
+
 		/// <summary> Return the optimal BWAPI::UnitType after running a sim </summary>
 		BWAPI::UnitType getOptimalUnit() const;
 
@@ -48,10 +204,43 @@ namespace BrawlSim
 		///     optimal/highest scored UnitType at the top </summary>
 		std::vector<std::pair<BWAPI::UnitType, double>> getUnitRanks() const;
 
+		/// <summary> Same order as getUnitRanks() but with the score variance and number of trials of each UnitType.
+		///     UnitTypes the budget ran out before simming are listed last with 0 trials and are never the optimal unit </summary>
+		std::vector<UnitRank> getUnitRankStats() const;
+
+		/// <summary> Number of FAP simulations run by the last simulateEach() or simulateForces() </summary>
+		int getSimCount() const;
+
+		/// <summary> FAP frames simulated by the last simulateEach() or simulateForces(), or by a startAsync() race up to the last pollAsync().
+		///     A trial stops counting once its combat is over </summary>
+		std::int64_t getFrameCount() const;
+
+		/// <summary> Where the time of the last simulateEach(), startEach() and its step() calls, simulateForces(), or startAsync() up to the last pollAsync() went.
+		///     Build BrawlSim with BRAWLSIM_PROFILE defined to fill in the times, otherwise only sims and frames are counted.</summary>
+		SimProfile getProfile() const;
+
 		/// <summary> Return a std::pair of the BWAPI::Player and int score of the force with the highest score remaining after a simulation (I.e. the winning player).
-		///		Returns std::pair of BWAPI::Broodwar->self() and NULL if scores are even </summary>
+		///		Returns std::pair of the friendly player and 0 if scores are even </summary>
 		std::pair<BWAPI::Player, int> getBestForce() const;
 
+		/// <summary> How each friendly unit of the last simulateForces() fared, in the order the units were given.
+		///     Invalid UnitTypes are skipped and Zerglings and Scourges count as two units </summary>
+		const std::vector<UnitOutcome>& getFriendlyOutcomes() const;
+
+		/// <summary> Same as getFriendlyOutcomes() for the enemy units </summary>
+		const std::vector<UnitOutcome>& getEnemyOutcomes() const;
+
+		/// <summary> Record a Timeline of every trial of the following simulateForces() calls, a snapshot of both sides every options.interval frames.
+		///     Trials run options.frames frames and each stops early once options.stop returns true, so the scores and outcomes are those of the
+		///     frame it stopped at. Calls recording timelines skip the result cache and the recorder. enabled false stops recording timelines.</summary>
+		void setTimeline(const bool enabled, const TimelineOptions& options = TimelineOptions());
+
+		/// <summary> Number of trials with a Timeline in the last simulateForces(), 0 unless setTimeline() is on </summary>
+		int getTimelineCount() const;
+
+		/// <summary> Timeline of trial t of the last simulateForces() </summary>
+		const Timeline& getTimeline(const int t) const;
+
 		/// <summary>Draw the 'would-be' optimal unit of the given friendly UnitTypes to the screen after a simulateEach() simulation
 		void drawOptimalUnit(const int x, const int y) const;
 		void drawOptimalUnit(const BWAPI::Position& pos) const;
@@ -72,37 +261,134 @@ namespace BrawlSim
 		void drawOptimalUnit(const BWAPI::Unit& building);*/
 
 	private:
-		FAP::FastAPproximation<UnitData*>				MCfap;
+		/// What a sim call leaves for the getters, kept by the result cache
+		struct CachedResult
+		{
+			std::vector<UnitRank>						unit_ranks;
+			BWAPI::UnitType								optimal_unit = BWAPI::UnitTypes::None;
+			int											friendly_score = 0;
+			int											enemy_score = 0;
+			std::vector<UnitOutcome>					friendly_outcomes;
+			std::vector<UnitOutcome>					enemy_outcomes;
+		};
 
-		std::vector<UnitData>							friendly_data;
-		std::map<UnitData, int>							enemy_data;
+		/// A unit of the simulateForces() trials, indexed by its UnitTag id
+		struct ForceUnit
+		{
+			const UnitData*								data;
+			int											start_hp;
+		};
+
+		GameContext*									game;
+		ThreadPool										pool;
+		std::uint64_t									seed = 0;
+
+		/// simulateEach() race, kept between step() calls
+		Race											race{ pool };
+		RaceBatch										batch{ pool };
+		CompositionSearch								composition{ pool };
+		RaceInput										report_input;
+		std::vector<double>								estimates;
+		std::vector<std::pair<double, BWAPI::UnitType>>	pruned;
+		TrialSims										force_trials;
+		SimEngine										engine = SimEngine::ArrayOfStructs;
+		int												target_grid_units = 100;
+		int												sims_run = 0;
+		std::int64_t									frames_run = 0;
+		SimProfile										profile;
+
+		/// Background race of startAsync(), started on first use
+		std::unique_ptr<AsyncRace>						async_race;
+		std::uint64_t									async_job = 0;
+		bool											async_done = true;
+		SimProfile										async_profile;
+
+		/// Converted units are copied from prototypes instead of querying BWAPI for every unit
+		PrototypeCache									prototypes;
+
+		ResultCache<CachedResult>						result_cache;
+		std::uint64_t									cache_key = 0;
+		bool											cache_pending = false;
+
+		/// Ranks and scaled enemy composition of the last finished race, carried over by startUpdate()
+		std::vector<UnitRank>							update_ranks;
+		std::vector<std::pair<int, int>>				update_enemies; // UnitType ID, count
+		std::uint64_t									update_key = 0;
+		std::vector<std::pair<int, int>>				pending_enemies;
+		std::uint64_t									pending_key = 0;
+		bool											update_pending = false;
+
+		/// Record of the running race for the recorder, written once the race is done
+		ScenarioWriter*									recorder = nullptr;
+		Scenario										record;
+		bool											record_pending = false;
+
+		std::vector<const UnitData*>					friendly_data;
+
+		EnemyComposition								enemy_data;
+
+		/// Buffers of the sim calls, kept so that calls after the first don't allocate
+		std::vector<BWAPI::UnitType>					friendly_type_buffer;
+		std::vector<BWAPI::UnitType>					enemy_type_buffer;
+		std::vector<const UnitData*>					enemy_order;
+		std::vector<ForceUnit>							friendly_start;
+		std::vector<ForceUnit>							enemy_start;
+		std::vector<int>								friendly_hp;
+		std::vector<int>								enemy_hp;
+		std::vector<int>								friendly_lost;
+		std::vector<int>								enemy_lost;
+		std::vector<int>								force_frames;
+
+		/// Timelines of the simulateForces() trials, kept between calls so their buffers are reused
+		bool											timeline_enabled = false;
+		TimelineOptions									timeline_options;
+		std::vector<Timeline>							timelines;
+		int												timeline_trials = 0;
 
 		int												friendly_score = 0;
 		int												enemy_score = 0;
-		bool											valid_enemies = true;
 
 		BWAPI::UnitType									optimal_unit = BWAPI::UnitTypes::None;
-		std::vector<std::pair<BWAPI::UnitType, double>>	unit_ranks;
+		std::vector<UnitRank>							unit_ranks;
+		std::vector<UnitOutcome>						friendly_outcomes;
+		std::vector<UnitOutcome>						enemy_outcomes;
 
 		/// TO DO - Condense these into enum bitset flags for static_asserts
-		static bool										simEachFlag;
-		static bool										simForcesFlag;
+		bool											simEachFlag = false;
+		bool											simForcesFlag = false;
 
 		bool isValidType(const BWAPI::UnitType& type);
 
-		void addEnemyTypes(const BWAPI::Unitset& units, const BWAPI::UnitType& friendly_type, int army_size);
-		void addFriendlyType(const BWAPI::UnitType& type, int& army_size);
+		static const std::vector<BWAPI::UnitType>& unitTypes(const BWAPI::Unitset& units, std::vector<BWAPI::UnitType>& types);
+
+		void buildEnemyData(const std::vector<BWAPI::UnitType>& types, int army_size);
+		bool canAttackEnemies(const BWAPI::UnitType& friendly_type) const;
+		int friendlyArmySize(const UnitData& data) const;
+		void convertEnemies(const std::vector<BWAPI::UnitType>& enemy_types, int army_size);
+		void makeRaceInput(RaceInput& input, const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type);
+		void prescreen(RaceInput& input);
+		void prepareSearch(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, int army_size);
+		void startRace(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size, const bool carry_over);
+		void carryOver(RaceInput& input) const;
+		void finishRace();
+		void publishRanks();
+
+		static void trackUnits(const std::vector<FAP::FAPUnit<UnitTag>>& units, std::vector<ForceUnit>& start);
+		static int tallySurvivors(const std::vector<FAP::FAPUnit<UnitTag>>& units, const std::vector<ForceUnit>& start, int* hp);
+		static void setOutcomes(const std::vector<ForceUnit>& start, const std::vector<int>& hp, const int trials, std::vector<UnitOutcome>& outcomes);
 
-		/// TO DO - Condense these into one function with enum flags
-		void checkAliveUnits(std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& friendly_pre_units, std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& enemy_pre_units);
-		void checkAliveFriendly(std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& friendly_pre_units);
-		void checkAliveEnemy(std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& enemy_pre_units);
+		double initialScore(const UnitData& data, const int scoring_type) const;
 
-		void setPostRank(const int scoring_type, const int army_size);
-		void sortRanks();
+		std::uint64_t eachKey(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, const int army_size) const;
+		std::uint64_t updateKey(const int scoring_type, const int army_size) const;
+		std::uint64_t forcesKey(const std::vector<BWAPI::UnitType>& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const int trials) const;
+		void cacheResult();
+		void restoreResult(const CachedResult& cached);
 
-		void setOptimalUnit();
+		void beginRecord(const Scenario::Kind kind, const std::vector<BWAPI::UnitType>& enemy_types);
+		void recordPrototype(const FAP::FAPUnit<UnitTag>& prototype, const int side);
 
 		void resetFlags();
+		void resetData();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BWAPI.h"
+
+#include "Race.hpp"
+#include "UnitRank.hpp"
+#include "ThreadPool.hpp"
+#include "ResultBuffer.hpp"
+
+namespace BrawlSim
+{
+	/// Runs simulateEach() races on a background thread.
+	/// The game thread hands over a RaceInput and later takes the latest ranks from a ResultBuffer without waiting for the worker.
+	class AsyncRace
+	{
+	public:
+		/// Ranks published by the worker
+		struct Result
+		{
+			std::vector<UnitRank>		ranks;
+			BWAPI::UnitType				optimal_unit = BWAPI::UnitTypes::None;
+			int							sims = 0;
+			std::int64_t				frames = 0;
+			SimProfile					profile;
+			bool						done = false;
+			std::uint64_t				job = 0;
+		};
+
+		/// <param name = "threads">
+		///		Threads working on the trials, including the background thread.
+		/// </param>
+		explicit AsyncRace(unsigned threads);
+		~AsyncRace();
+
+		AsyncRace(const AsyncRace&) = delete;
+		AsyncRace& operator=(const AsyncRace&) = delete;
+
+		/// <summary> Replace the race the worker is running with one over input. Results of the new race carry job </summary>
+		void start(RaceInput&& input, const std::uint64_t job);
+
+		/// <summary> Stop the running race and drop one not yet taken by the worker. Results already published are kept </summary>
+		void cancel();
+
+		/// <summary> Take the latest result published by the worker. Returns false if there is nothing new </summary>
+		bool poll();
+
+		/// <summary> Result taken by the last poll() </summary>
+		const Result& result() const;
+
+	private:
+		/// Time the worker runs between checks for a new race or a stop
+		static const int				slice_microseconds = 2000;
+
+		ThreadPool						pool;
+		Race							race;
+		ResultBuffer<Result>			results;
+
+		std::mutex						mutex;
+		std::condition_variable			wake;
+		RaceInput						pending;
+		std::uint64_t					pending_job = 0;
+		std::atomic<bool>				has_pending{ false };
+		std::atomic<bool>				stopping{ false };
+		std::atomic<bool>				cancelled{ false };
+
+		std::thread						worker;
+
+		void workerLoop();
+		void publish(const std::uint64_t job);
+	};
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "BWAPI.h"
+#include "FAP.hpp"
+
+#include "Random.hpp"
+#include "UnitTag.hpp"
+#include "UnitRank.hpp"
+#include "ThreadPool.hpp"
+#include "TrialSims.hpp"
+
+class UnitData;
+
+namespace BrawlSim
+{
+	/// What a searched army may cost. Supply is in BWAPI's units, twice the supply shown in game
+	struct ArmyBudget
+	{
+		int								minerals = 0;
+		int								gas = 0;
+		int								supply = 400;
+	};
+
+	/// How hard Brawl::searchComposition() searches
+	struct CompositionOptions
+	{
+		/// Mixes kept after each step of the search. 1 is a greedy search
+		int								beam_width = 4;
+
+		/// Each step adds about 1/steps of the budget's worth of one UnitType to a mix
+		int								steps = 8;
+
+		/// Monte Carlo trials per mix. Every mix is simmed against the same trials, so they compare fairly with few of them
+		int								trials = 4;
+
+		/// Passes of the local search that trades a step's worth of one UnitType for another once the budget is spent
+		int								swap_passes = 2;
+	};
+
+	/// Best army found by Brawl::searchComposition()
+	struct CompositionResult
+	{
+		/// UnitTypes to build and how many of each. Zerglings and Scourges are counted in pairs, as they are trained
+		std::vector<std::pair<BWAPI::UnitType, int>>	units;
+
+		/// Mean over the trials of the eco score left of the army minus that left of the enemy, over the enemy's starting eco score
+		double							score = -1;
+		double							variance = 0;
+
+		int								minerals = 0;
+		int								gas = 0;
+		int								supply = 0;
+
+		/// Mixes simmed, FAP simulations run and FAP frames simulated by the search
+		int								candidates = 0;
+		int								sims = 0;
+		std::int64_t					frames = 0;
+	};
+
+	/// How Brawl::findBreakEven() searches
+	struct BreakEvenOptions
+	{
+		/// Monte Carlo trials per army size. Every size is simmed against the same trials
+		int								trials = 8;
+
+		/// Share of the trials an army has to win to beat the enemy. A trial is won if the army has more eco score left than the enemy
+		double							win_rate = 0.5;
+
+		/// Largest army tried
+		int								max_count = 200;
+	};
+
+	/// Fewest units of a UnitType found by Brawl::findBreakEven() to beat the enemy
+	struct BreakEven
+	{
+		BWAPI::UnitType					type = BWAPI::UnitTypes::None;
+
+		/// Zerglings and Scourges are counted in pairs, as they are trained. 0 if max_count doesn't beat the enemy
+		int								count = 0;
+
+		/// Share of the trials won by count units, or by max_count units if they don't beat the enemy
+		double							win_rate = 0;
+
+		/// Army sizes simmed to find count
+		int								probes = 0;
+	};
+
+	/// Beam search over mixes of the friendly UnitTypes that fit in an ArmyBudget, followed by a local search of trades between them,
+	/// and the search for the army size of each UnitType that beats the enemy.
+	/// Each step's armies are simmed together in one parallelFor from the prototypes, against enemy armies built once per search.
+	/// Only reads its prototypes, so it doesn't call BWAPI.
+	class CompositionSearch
+	{
+	public:
+		explicit CompositionSearch(ThreadPool& thread_pool);
+
+		/// <summary> Drop the UnitTypes and enemies of the last search </summary>
+		void clear();
+
+		/// <summary> Let the search build the prototype's UnitType. guess is where breakEven() starts searching its army size </summary>
+		void addOption(const FAP::FAPUnit<UnitTag>& prototype, const int guess = 1);
+
+		/// <summary> Add count units of the prototype's UnitType to the enemy army </summary>
+		void addEnemies(const FAP::FAPUnit<UnitTag>& prototype, const int count);
+
+		/// <summary> Search for the best mix within budget </summary>
+		const CompositionResult& run(const ArmyBudget& budget, const CompositionOptions& options, const std::uint64_t seed, const SimEngine engine, const int grid_units);
+
+		const CompositionResult& result() const;
+
+		/// <summary> Search the fewest units of each option that beat the enemy, doubling the army from its guess until it wins,
+		///     then halving the interval to the last army that lost. The options' armies of a round are simmed together in one parallelFor </summary>
+		const std::vector<BreakEven>& breakEven(const BreakEvenOptions& search_options, const std::uint64_t seed, const SimEngine engine, const int grid_units);
+
+		const std::vector<BreakEven>& breakEvenResults() const;
+
+		/// <summary> Number of FAP simulations run by the last run() or breakEven() </summary>
+		int simCount() const;
+
+		/// <summary> FAP frames simulated by the last run() or breakEven(), not counting the frames of a trial after its combat was over </summary>
+		std::int64_t frameCount() const;
+
+	private:
+		/// Count of each option
+		using Mix = std::vector<int>;
+
+		/// A friendly UnitType and what one of it costs to train
+		struct Option
+		{
+			FAP::FAPUnit<UnitTag>						prototype;
+			int											minerals;
+			int											gas;
+			int											supply;
+			int											guess = 1;
+			int											chunk = 0;
+		};
+
+		struct EnemyGroup
+		{
+			FAP::FAPUnit<UnitTag>						prototype;
+			int											count;
+		};
+
+		struct Candidate
+		{
+			Mix											mix;
+			RunningStats								stats;
+			int											wins = 0;
+
+			explicit Candidate(const Mix& candidate_mix)
+				: mix(candidate_mix)
+			{
+			}
+		};
+
+		/// Army sizes of an option known to lose and to win, 0 and -1 until one is simmed
+		struct Bracket
+		{
+			int											option;
+			int											lost = 0;
+			int											won = -1;
+			int											probe = 1;
+			double										won_rate = 0;
+			double										lost_rate = 0;
+		};
+
+		ThreadPool&										pool;
+		TrialSims										trials;
+
+		std::vector<Option>								options;
+		std::vector<EnemyGroup>							enemies;
+		double											enemy_value = 0;
+		ArmyBudget										limits;
+
+		std::vector<std::vector<FAP::FAPUnit<UnitTag>>>	enemy_snapshots;
+		std::vector<Rng>								enemy_rngs;
+
+		std::vector<Candidate>							candidates;
+		std::vector<Mix>								beam;
+		std::set<Mix>									seen;
+		std::vector<double>								trial_scores;
+		std::vector<int>								trial_frames;
+
+		CompositionResult								search_result;
+		int												sims_run = 0;
+		std::int64_t									frames_run = 0;
+		std::vector<BreakEven>							break_even;
+		std::vector<Bracket>							brackets;
+
+		void buildEnemySnapshots(const std::uint64_t seed, const int trial_count);
+		int room(const Mix& mix, const int i) const;
+		void propose(const Mix& mix);
+		void evaluate(const int trial_count);
+		double trialScore(FAP::FastAPproximation<UnitTag>& sim) const;
+		void setResult(const Candidate& best);
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "BWAPI.h"
+
+class UnitData;
+
+namespace BrawlSim
+{
+	/// Count of each enemy UnitType in a sim. Indexed by UnitType ID, so counting a unit is a table lookup,
+	/// and the groups are kept in UnitType ID order so every sim adds the enemy types in the same order.
+	/// Keeps its memory between sims.
+	class EnemyComposition
+	{
+	public:
+		/// An enemy UnitType, the UnitData of its prototype and how many units of it are in the sim
+		struct Group
+		{
+			const UnitData*				data;
+			int							count;
+		};
+
+		EnemyComposition();
+
+		/// <summary> Count one more unit of the data's UnitType </summary>
+		void add(const UnitData& data);
+
+		/// <summary> Scale every count to its share of army_size in one pass. A type keeps its group even if it scales to 0 </summary>
+		void scale(const int army_size);
+
+		/// <summary> Drop every group </summary>
+		void clear();
+
+		/// <summary> True if any UnitType of the composition is a flyer </summary>
+		bool hasAir() const;
+
+		/// <summary> True if any UnitType of the composition is on the ground </summary>
+		bool hasGround() const;
+
+		/// <summary> Number of units added since the last clear(), before scaling </summary>
+		int unitTotal() const;
+
+		std::vector<Group>::const_iterator begin() const;
+		std::vector<Group>::const_iterator end() const;
+
+	private:
+		std::vector<Group>								groups;
+
+		/// Index of each UnitType's group, -1 if it has none
+		std::array<int, BWAPI::UnitTypes::Enum::MAX>	slots;
+
+		int												unit_total = 0;
+		int												air_types = 0;
+	};
+}
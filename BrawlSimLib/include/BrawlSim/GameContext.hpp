@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "BWAPI.h"
+
+namespace BrawlSim
+{
+	/// Everything Brawl needs from a running game: the two players it sims and somewhere to report to.
+	/// The UnitData conversion only reads the players' upgrades, so a Player of any GameContext works.
+	class GameContext
+	{
+	public:
+		virtual ~GameContext() = default;
+
+		/// <summary> Player whose UnitTypes are friendly in the sims </summary>
+		virtual BWAPI::Player self() const = 0;
+
+		/// <summary> Player whose UnitTypes are enemies in the sims </summary>
+		virtual BWAPI::Player enemy() const = 0;
+
+		/// <summary> Frames since the start of the game. Ages the results Brawl caches </summary>
+		virtual int frameCount() const = 0;
+
+		/// <summary> Report a message, such as the misuse of a Brawl function </summary>
+		virtual void sendText(const std::string& text) = 0;
+
+		/// <summary> Draw text at screen coordinates </summary>
+		virtual void drawTextScreen(const int x, const int y, const std::string& text) = 0;
+	};
+
+	/// GameContext of the BWAPI::Broodwar game the AI module runs in
+	class LiveGame : public GameContext
+	{
+	public:
+		BWAPI::Player self() const override;
+		BWAPI::Player enemy() const override;
+		int frameCount() const override;
+		void sendText(const std::string& text) override;
+		void drawTextScreen(const int x, const int y, const std::string& text) override;
+	};
+
+	/// <summary> Shared LiveGame used by a default constructed Brawl </summary>
+	GameContext& liveGame();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "BWAPI.h"
+
+#include "Race.hpp"
+
+namespace BrawlSim
+{
+	/// <summary> Score the contender is expected to get in a FAP trial against the enemies, without simming it.
+	///     Solves a Lanchester square law fight over a trial's frames from the damage, cooldowns, armor, shields, sizes, ranges and speeds
+	///     of the prototypes. Enemies the contender can't hit keep dealing damage at a constant rate. Costs about as much as a FAP frame of one unit.</summary>
+	double lanchesterScore(const RaceInput::Contender& contender, const std::vector<RaceInput::EnemyGroup>& enemies);
+
+	/// A raced UnitType's Lanchester estimate next to its FAP score
+	struct PrescreenEntry
+	{
+		BWAPI::UnitType					type = BWAPI::UnitTypes::None;
+		double							estimate = 0;
+		double							score = 0;
+		int								sims = 0;
+	};
+
+	/// How well the Lanchester estimate ranks the UnitTypes of a simulateEach() race compared to FAP
+	struct PrescreenReport
+	{
+		/// Every raced UnitType, highest FAP score first
+		std::vector<PrescreenEntry>		entries;
+
+		/// Spearman correlation of the estimate and FAP ranks. 1 when both rank the UnitTypes the same
+		double							rank_correlation = 0;
+
+		/// Mean absolute difference of the estimate and the FAP score
+		double							mean_error = 0;
+
+		/// Estimate of the FAP winner over the best estimate. SimBudget::prune_below has to stay below it to keep the winner
+		double							winner_ratio = 0;
+	};
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <ostream>
+#include <string>
+
+#include "BWAPI.h"
+
+#include "GameContext.hpp"
+
+namespace BrawlSim
+{
+	/// Player outside of a game. Its upgrade levels and researched techs are set by hand and it has no units or resources.
+	/// PlayerInterface's damage, armor, range and speed helpers work on it since they only read the upgrades and techs.
+	class OfflinePlayer : public BWAPI::PlayerInterface
+	{
+	public:
+		OfflinePlayer(const int id, const BWAPI::Race& race, const std::string& name);
+		~OfflinePlayer() override = default;
+
+		/// <summary> Set the level of an upgrade. Changes the player's upgradeFingerprint(), so cached prototypes are rebuilt </summary>
+		void setUpgradeLevel(const BWAPI::UpgradeType& upgrade, const int level);
+
+		/// <summary> Set whether a tech is researched </summary>
+		void setResearched(const BWAPI::TechType& tech, const bool researched = true);
+
+		int getID() const override;
+		std::string getName() const override;
+		const BWAPI::Unitset& getUnits() const override;
+		BWAPI::Race getRace() const override;
+		BWAPI::PlayerType getType() const override;
+		BWAPI::Force getForce() const override;
+		bool isAlly(const BWAPI::Player player) const override;
+		bool isEnemy(const BWAPI::Player player) const override;
+		bool isNeutral() const override;
+		BWAPI::TilePosition getStartLocation() const override;
+		bool isVictorious() const override;
+		bool isDefeated() const override;
+		bool leftGame() const override;
+		int minerals() const override;
+		int gas() const override;
+		int gatheredMinerals() const override;
+		int gatheredGas() const override;
+		int repairedMinerals() const override;
+		int repairedGas() const override;
+		int refundedMinerals() const override;
+		int refundedGas() const override;
+		int spentMinerals() const override;
+		int spentGas() const override;
+		int supplyTotal(BWAPI::Race race = BWAPI::Races::None) const override;
+		int supplyUsed(BWAPI::Race race = BWAPI::Races::None) const override;
+		int allUnitCount(BWAPI::UnitType unit = BWAPI::UnitTypes::AllUnits) const override;
+		int visibleUnitCount(BWAPI::UnitType unit = BWAPI::UnitTypes::AllUnits) const override;
+		int completedUnitCount(BWAPI::UnitType unit = BWAPI::UnitTypes::AllUnits) const override;
+		int deadUnitCount(BWAPI::UnitType unit = BWAPI::UnitTypes::AllUnits) const override;
+		int killedUnitCount(BWAPI::UnitType unit = BWAPI::UnitTypes::AllUnits) const override;
+		int getUpgradeLevel(BWAPI::UpgradeType upgrade) const override;
+		bool hasResearched(BWAPI::TechType tech) const override;
+		bool isResearching(BWAPI::TechType tech) const override;
+		bool isUpgrading(BWAPI::UpgradeType upgrade) const override;
+		BWAPI::Color getColor() const override;
+		int getUnitScore() const override;
+		int getKillScore() const override;
+		int getBuildingScore() const override;
+		int getRazingScore() const override;
+		int getCustomScore() const override;
+		bool isObserver() const override;
+		int getMaxUpgradeLevel(BWAPI::UpgradeType upgrade) const override;
+		bool isResearchAvailable(BWAPI::TechType tech) const override;
+		bool isUnitAvailable(BWAPI::UnitType unit) const override;
+
+	private:
+		int															id;
+		BWAPI::Race													race;
+		std::string													name;
+		BWAPI::Unitset												units;
+
+		std::array<int, BWAPI::UpgradeTypes::Enum::MAX>				upgrade_levels{};
+		std::array<bool, BWAPI::TechTypes::Enum::MAX>				researched{};
+	};
+
+	/// GameContext without Brood War, for running sims headless. Set the players' upgrades through self() and enemy()
+	/// before a sim and pass the enemy army as UnitTypes. Text goes to an optional stream.
+	class OfflineGame : public GameContext
+	{
+	public:
+		/// <param name = "log">
+		///		Stream for sendText() and drawTextScreen(). Default nullptr discards them.
+		/// </param>
+		OfflineGame(const BWAPI::Race& self_race, const BWAPI::Race& enemy_race, std::ostream* log = nullptr);
+
+		OfflinePlayer* self() const override;
+		OfflinePlayer* enemy() const override;
+		int frameCount() const override;
+		void sendText(const std::string& text) override;
+		void drawTextScreen(const int x, const int y, const std::string& text) override;
+
+		/// <summary> Set the frame reported by frameCount(). An offline game only moves on when told to </summary>
+		void setFrameCount(const int frame);
+
+	private:
+		/// Players are modified through self() and enemy() like a game's players
+		mutable OfflinePlayer										self_player;
+		mutable OfflinePlayer										enemy_player;
+		std::ostream*												log;
+		int															frame = 0;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "BWAPI.h"
+#include "FAP.hpp"
+
+#include "Random.hpp"
+#include "UnitTag.hpp"
+#include "UnitStats.hpp"
+
+class UnitData;
+
+namespace BrawlSim
+{
+	/// Hash of every upgrade level and researched tech of a player. Changes when an upgrade or tech completes
+	std::uint64_t upgradeFingerprint(const BWAPI::Player& player);
+
+	/// Converted FAP units for each (UnitType, Player). Converting a UnitData queries BWAPI dozens of times,
+	/// so each type is converted once and the sims get copies of the prototype with a new position.
+	/// A player's prototypes are rebuilt only after one of its upgrades or techs completes.
+	class PrototypeCache
+	{
+	public:
+		PrototypeCache();
+		~PrototypeCache();
+
+		/// <summary> Check the player's upgrade state and drop its prototypes if an upgrade or tech completed since the last refresh </summary>
+		void refresh(const BWAPI::Player& player);
+
+		/// <summary> UnitData of the UnitType for the player. Built on first use and stays at the same address until the player's prototypes are dropped </summary>
+		const UnitData& data(const BWAPI::UnitType& type, const BWAPI::Player& player);
+
+		/// <summary> Converted FAPUnit of the UnitType for the player at (0, 0) </summary>
+		const FAP::FAPUnit<UnitTag>& prototype(const BWAPI::UnitType& type, const BWAPI::Player& player);
+
+		/// <summary> Copy of the UnitType's prototype at a position drawn from the trial's rng </summary>
+		FAP::FAPUnit<UnitTag> stamp(const BWAPI::UnitType& type, const BWAPI::Player& player, Rng& rng);
+
+		/// <summary> Upgrade fingerprint of the player as of its last refresh(), 0 before the first </summary>
+		std::uint64_t fingerprint(const BWAPI::Player& player) const;
+
+		/// <summary> Drop every prototype </summary>
+		void clear();
+
+		/// <summary> Survival rates of the UnitData built from now on. Drops every prototype </summary>
+		void setSurvivalRates(const SurvivalRates& rates);
+
+	private:
+		/// UnitData and its prototype. Defined in the source so this header doesn't need UnitData
+		struct Entry;
+
+		std::unordered_map<std::uint64_t, std::unique_ptr<Entry>>	entries;
+		std::unordered_map<int, std::uint64_t>						fingerprints;
+		SurvivalRates												survival_rates = default_survival_rates;
+
+		Entry& entry(const BWAPI::UnitType& type, const BWAPI::Player& player);
+	};
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "BWAPI.h"
+#include "FAP.hpp"
+
+#include "Random.hpp"
+#include "UnitTag.hpp"
+#include "UnitRank.hpp"
+#include "SimBudget.hpp"
+#include "ThreadPool.hpp"
+#include "TrialSims.hpp"
+#include "SimProfile.hpp"
+
+class UnitData;
+
+namespace BrawlSim
+{
+	/// Everything a simulateEach() race needs, taken from the game on the game thread.
+	/// The input owns copies of the UnitData its prototypes point at, so the race doesn't query BWAPI
+	/// and can run on another thread while the game moves on.
+	struct RaceInput
+	{
+		/// A friendly UnitType in the race
+		struct Contender
+		{
+			FAP::FAPUnit<UnitTag>		prototype;
+			int							army_size;
+			double						initial_score;
+
+			/// Trials carried over from an earlier race, counted as if they were run in this one
+			RunningStats				prior;
+		};
+
+		/// An enemy UnitType and how many of it every trial has
+		struct EnemyGroup
+		{
+			FAP::FAPUnit<UnitTag>		prototype;
+			int							count;
+		};
+
+		std::vector<Contender>			contenders;
+		std::vector<EnemyGroup>			enemies;
+
+		/// UnitTypes that aren't raced, ranked by their initial score or 0
+		std::vector<UnitRank>			unraced_ranks;
+
+		/// UnitTypes the Lanchester pre-screen left out, best estimate first. Listed after every raced UnitType with a score of 0
+		std::vector<UnitRank>			pruned_ranks;
+
+		SimBudget						budget;
+		std::uint64_t					seed = 0;
+		SimEngine						engine = SimEngine::ArrayOfStructs;
+		int								target_grid_units = 100;
+
+		/// <summary> Copy of prototype pointing at a copy of data owned by the input </summary>
+		FAP::FAPUnit<UnitTag> own(const UnitData& data, const FAP::FAPUnit<UnitTag>& prototype);
+
+		/// <summary> Empty the input for the next race. Keeps its memory, so refilling it doesn't allocate </summary>
+		void clear();
+
+	private:
+		/// Copies made by own(). Reused in order after clear()
+		std::vector<std::shared_ptr<UnitData>>	unit_data;
+		size_t									owned = 0;
+	};
+
+	/// The simulateEach() race of the friendly UnitTypes, run a step at a time.
+	/// Only reads its RaceInput, so it doesn't need to run on the game thread.
+	class Race
+	{
+	public:
+		explicit Race(ThreadPool& thread_pool);
+
+		/// <summary> Replace the running race with one over input. No trials are run yet </summary>
+		void start(RaceInput&& input);
+
+		/// <summary> Cleared input of the race to be filled in place and run with start() </summary>
+		RaceInput& prepare();
+
+		/// <summary> Replace the running race with one over the input filled through prepare() </summary>
+		void start();
+
+		/// <summary> Advance the race by at most the step budget, then return true if it is done </summary>
+		bool step(const StepBudget& step_budget);
+
+		/// <summary> Stop the race and drop its ranks </summary>
+		void reset();
+
+		/// <summary> Set up the next round and return its number of trials, 0 once the race is done.
+		///     Lets a RaceBatch run the rounds of several races in one parallelFor instead of step() </summary>
+		int beginRound();
+
+		/// <summary> Simulate trial j of the round to its end. The round's trials can run on different threads </summary>
+		void runTrial(const int j);
+
+		/// <summary> Score the round once every trial has run. microseconds is the round's wall clock time, charged against the budget </summary>
+		void endRound(const std::int64_t microseconds);
+
+		bool isDone() const;
+
+		/// <summary> Ranks of the trials finished so far, highest score first </summary>
+		const std::vector<UnitRank>& ranks() const;
+
+		/// <summary> Highest ranked UnitType. Ties go to a UnitType that hits both air and ground </summary>
+		BWAPI::UnitType optimalUnit() const;
+
+		/// <summary> Number of FAP simulations run so far </summary>
+		int simCount() const;
+
+		/// <summary> FAP frames simulated so far, not counting the frames of a trial after its combat was over </summary>
+		std::int64_t frameCount() const;
+
+		/// <summary> Profile of the race so far </summary>
+		const SimProfile& profile() const;
+
+	private:
+		/// A contender and its trial scores so far
+		struct Runner
+		{
+			const RaceInput::Contender*	contender;
+			RunningStats				stats;
+			bool						racing = true;
+		};
+
+		ThreadPool&										pool;
+		TrialSims										trials;
+		std::vector<double>								trial_scores;
+
+		RaceInput										input;
+		std::vector<Runner>								runners;
+
+		/// Each trial's enemy army, built once per race and copied into every contender's sim
+		std::vector<std::vector<FAP::FAPUnit<UnitTag>>>	enemy_snapshots;
+		std::vector<Rng>								enemy_rngs;
+		int												snapshot_count = 0;
+		int												sims_run = 0;
+		std::int64_t									frames_run = 0;
+
+		std::vector<std::pair<int, int>>				round_jobs; // runner, trial
+		std::vector<int>								frames_left;
+		std::vector<int>								frames_done;
+		std::vector<int>								units_at_start;
+		int												open_runners = 0;
+		std::int64_t									race_time = 0;
+		bool											round_running = false;
+		bool											done = true;
+
+		std::vector<UnitRank>							unit_ranks;
+		BWAPI::UnitType									optimal_unit = BWAPI::UnitTypes::None;
+		SimProfile										race_profile;
+
+		void addEnemyTypes(std::vector<FAP::FAPUnit<UnitTag>>& units, Rng& rng) const;
+		void buildEnemySnapshots(const int count);
+		void addContender(FAP::FastAPproximation<UnitTag>& sim, const RaceInput::Contender& contender, Rng& rng) const;
+		double postScore(FAP::FastAPproximation<UnitTag>& sim, const double initial_score, const int army_size) const;
+
+		bool startRound();
+		bool advanceRound(const int frames);
+		void advanceTrial(const int j, const int frames);
+		void finishRound();
+		int dropTrailing();
+		void publishRanks();
+		void setOptimalUnit(const size_t ranked);
+	};
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "BWAPI.h"
+
+#include "UnitRank.hpp"
+#include "SimBudget.hpp"
+#include "ThreadPool.hpp"
+#include "Race.hpp"
+
+namespace BrawlSim
+{
+	/// One simulateEach() question of a Brawl::simulateBatch() call
+	struct EachQuery
+	{
+		BWAPI::UnitType::set			friendly_types;
+		std::vector<BWAPI::UnitType>	enemy_types;
+		SimBudget						budget = SimBudget::fixed(1);
+		int								scoring_type = 0;
+		int								army_size = -1;
+	};
+
+	/// Answer to an EachQuery, the same as getUnitRankStats() and getOptimalUnit() after a simulateEach() of the query
+	struct EachResult
+	{
+		std::vector<UnitRank>			ranks;
+		BWAPI::UnitType					optimal_unit = BWAPI::UnitTypes::None;
+		int								sims = 0;
+		std::int64_t					frames = 0;
+	};
+
+	/// Several simulateEach() races run together. Each round, the trials of every race still running go to one parallelFor,
+	/// so the threads stay busy when a race is down to a few runners. Races are kept between batches so their buffers are reused.
+	class RaceBatch
+	{
+	public:
+		explicit RaceBatch(ThreadPool& thread_pool);
+
+		/// <summary> Make room for count races and drop the results of the last batch </summary>
+		void resize(const int count);
+
+		/// <summary> Cleared input of race i, to be filled in place before run() </summary>
+		RaceInput& prepare(const int i);
+
+		/// <summary> Run every race to its end </summary>
+		void run();
+
+		const Race& race(const int i) const;
+
+		int size() const;
+
+	private:
+		ThreadPool&										pool;
+		std::vector<std::unique_ptr<Race>>				races;
+		int												race_count = 0;
+
+		std::vector<std::pair<int, int>>				jobs; // race, trial
+		std::vector<int>								round_races;
+	};
+}
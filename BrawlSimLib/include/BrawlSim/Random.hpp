@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace BrawlSim
+{
+	/// xoshiro256** generator (http://prng.di.unimi.it/). Cheap enough to draw thousands of positions per frame.
+	/// Each Monte Carlo trial gets its own stream from Rng(seed, trial) so parallel trials don't share state
+	/// and a sim is reproducible for a given seed.
+	class Rng
+	{
+	public:
+		explicit Rng(const std::uint64_t seed = 0, const std::uint64_t stream = 0)
+		{
+			// SplitMix64 spreads (seed, stream) over the whole state so neighbouring trials aren't correlated
+			std::uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+			for (auto& word : state)
+			{
+				x += 0x9E3779B97F4A7C15ull;
+				std::uint64_t z = x;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				word = z ^ (z >> 31);
+			}
+		}
+
+		std::uint64_t next()
+		{
+			const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+			const std::uint64_t t = state[1] << 17;
+
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = rotl(state[3], 45);
+
+			return result;
+		}
+
+		/// Uniform int in [lo, hi]. Same result on every platform, unlike std::uniform_int_distribution
+		int range(const int lo, const int hi)
+		{
+			if (hi <= lo)
+			{
+				return lo;
+			}
+			const std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+			return static_cast<int>(lo + static_cast<std::int64_t>(((next() >> 32) * span) >> 32));
+		}
+
+	private:
+		std::uint64_t state[4];
+
+		static std::uint64_t rotl(const std::uint64_t x, const int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+namespace BrawlSim
+{
+	/// Lock-free triple buffer between one writer thread and one reader thread.
+	/// The writer fills back() and publishes it, the reader takes the latest published slot with update() and reads front().
+	/// With a third slot in the middle neither side ever waits for the other, and a slot isn't written while it is read.
+	template<typename T>
+	class ResultBuffer
+	{
+	public:
+		/// <summary> Slot the writer fills. Only the writer may touch it </summary>
+		T& back()
+		{
+			return slots[back_index];
+		}
+
+		/// <summary> Hand back() to the reader. The writer continues in the slot the reader isn't using </summary>
+		void publish()
+		{
+			back_index = middle.exchange(back_index | fresh, std::memory_order_acq_rel) & index_mask;
+		}
+
+		/// <summary> Take the latest published slot as front(). Returns false if nothing was published since the last update </summary>
+		bool update()
+		{
+			if (!(middle.load(std::memory_order_relaxed) & fresh))
+			{
+				return false;
+			}
+			front_index = middle.exchange(front_index, std::memory_order_acq_rel) & index_mask;
+			return true;
+		}
+
+		/// <summary> Slot the reader reads. Only the reader may touch it </summary>
+		const T& front() const
+		{
+			return slots[front_index];
+		}
+
+	private:
+		/// The middle index has this bit set while it holds a slot the reader hasn't taken
+		static const int		fresh = 4;
+		static const int		index_mask = 3;
+
+		T						slots[3];
+		int						back_index = 0;
+		int						front_index = 1;
+		std::atomic<int>		middle{ 2 };
+	};
+}
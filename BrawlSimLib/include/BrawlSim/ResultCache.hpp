@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace BrawlSim
+{
+	/// Builds the 64 bit key of a ResultCache entry from the values a sim result depends on
+	class CacheKey
+	{
+	public:
+		/// <summary> Mix a value into the key. Order matters </summary>
+		void add(const std::uint64_t value)
+		{
+			hash = mix(hash ^ value);
+		}
+
+		/// <summary> Mix in a multiset of values. The same values in any order give the same key </summary>
+		template<typename Range, typename Id>
+		void addUnordered(const Range& range, Id id)
+		{
+			std::uint64_t sum = 0;
+			std::uint64_t count = 0;
+			for (const auto& v : range)
+			{
+				sum += mix(static_cast<std::uint64_t>(id(v)));
+				++count;
+			}
+			add(sum);
+			add(count);
+		}
+
+		std::uint64_t value() const
+		{
+			return hash;
+		}
+
+	private:
+		std::uint64_t				hash = 0xCBF29CE484222325ull;
+
+		/// splitmix64 finalizer
+		static std::uint64_t mix(std::uint64_t x)
+		{
+			x ^= x >> 30;
+			x *= 0xBF58476D1CE4E5B9ull;
+			x ^= x >> 27;
+			x *= 0x94D049BB133111EBull;
+			x ^= x >> 31;
+			return x;
+		}
+	};
+
+	/// Lookups of a ResultCache since it was configured
+	struct CacheStats
+	{
+		std::uint64_t				hits = 0;
+		std::uint64_t				misses = 0;
+
+		/// Misses that found the key, but older than the allowed age
+		std::uint64_t				stale = 0;
+
+		/// Entries dropped to make room for a new one
+		std::uint64_t				evictions = 0;
+	};
+
+	/// Least recently used cache of sim results, keyed by a CacheKey and aged in game frames.
+	/// Holds a few entries, so lookups scan them in place. Entries are overwritten in place, so once full it doesn't allocate
+	/// for values whose memory is reused by assignment.
+	template<typename Value>
+	class ResultCache
+	{
+	public:
+		/// <summary> Hold up to capacity results, each usable for max_age frames after it was stored. A negative max_age never ages them.
+		///     A capacity of 0 turns the cache off. Drops every entry and resets the stats </summary>
+		void configure(const int capacity, const int max_age_frames)
+		{
+			entries.resize(capacity > 0 ? capacity : 0);
+			max_age = max_age_frames;
+			clear();
+			cache_stats = CacheStats();
+		}
+
+		bool enabled() const
+		{
+			return !entries.empty();
+		}
+
+		/// <summary> Result stored under key at most max_age frames before frame, or nullptr </summary>
+		const Value* find(const std::uint64_t key, const int frame)
+		{
+			for (auto& e : entries)
+			{
+				if (e.used && e.key == key)
+				{
+					if (max_age >= 0 && frame - e.frame > max_age)
+					{
+						e.used = false;
+						++cache_stats.stale;
+						break;
+					}
+					e.last_used = ++clock;
+					++cache_stats.hits;
+					return &e.value;
+				}
+			}
+			++cache_stats.misses;
+			return nullptr;
+		}
+
+		/// <summary> Slot for the result of key at frame, taken from the least recently used entry. The caller writes the value </summary>
+		Value& insert(const std::uint64_t key, const int frame)
+		{
+			Entry* slot = &entries.front();
+			for (auto& e : entries)
+			{
+				if (!e.used || e.key == key)
+				{
+					slot = &e;
+					break;
+				}
+				if (e.last_used < slot->last_used)
+				{
+					slot = &e;
+				}
+			}
+			cache_stats.evictions += slot->used && slot->key != key;
+			slot->key = key;
+			slot->frame = frame;
+			slot->last_used = ++clock;
+			slot->used = true;
+			return slot->value;
+		}
+
+		/// <summary> Drop every entry, for when something the keys don't cover changed </summary>
+		void clear()
+		{
+			for (auto& e : entries)
+			{
+				e.used = false;
+			}
+		}
+
+		const CacheStats& stats() const
+		{
+			return cache_stats;
+		}
+
+	private:
+		struct Entry
+		{
+			std::uint64_t			key = 0;
+			int						frame = 0;
+			std::uint64_t			last_used = 0;
+			bool					used = false;
+			Value					value;
+		};
+
+		std::vector<Entry>			entries;
+		int							max_age = -1;
+		std::uint64_t				clock = 0;
+		CacheStats					cache_stats;
+	};
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BWAPI.h"
+#include "FAP.hpp"
+
+#include "UnitTag.hpp"
+#include "UnitRank.hpp"
+#include "SimBudget.hpp"
+#include "TrialSims.hpp"
+
+namespace BrawlSim
+{
+	/// A player's upgrade levels and researched techs, only those above 0
+	struct ScenarioPlayer
+	{
+		std::vector<std::pair<int, int>>			upgrades; // UpgradeType ID, level
+		std::vector<int>							techs;
+	};
+
+	/// A prototype a recorded sim copied its units from, with the UnitData values the sim read
+	struct ScenarioPrototype
+	{
+		/// 0 for the friendly player, 1 for the enemy
+		int											side = 0;
+		FAP::FAPUnit<UnitTag>						unit{};
+		int											eco_score = 0;
+		double										survival_rate = 0;
+		double										top_speed = 0;
+	};
+
+	/// Everything a simulateEach() race or a simulateForces() call was run with, and what it returned.
+	/// Unit positions aren't stored: trial t draws them from stream t of the seed, so the seed reproduces every one of them.
+	struct Scenario
+	{
+		enum class Kind : std::uint8_t
+		{
+			Each = 1,
+			Forces = 2
+		};
+
+		Kind										kind = Kind::Each;
+		std::uint64_t								seed = 0;
+		int											frame = 0;
+		SimEngine									engine = SimEngine::ArrayOfStructs;
+
+		/// simulateEach() arguments
+		SimBudget									budget;
+		int											scoring_type = 0;
+		int											army_size = -1;
+
+		/// simulateForces() trials
+		int											trials = 0;
+
+		/// Self, then enemy
+		std::array<ScenarioPlayer, 2>				players;
+
+		/// The friendly UnitTypes raced by simulateEach(), or the friendly army of simulateForces() in order
+		std::vector<BWAPI::UnitType>				friendly_types;
+		std::vector<BWAPI::UnitType>				enemy_types;
+		std::vector<ScenarioPrototype>				prototypes;
+
+		/// simulateEach() results
+		std::vector<UnitRank>						ranks;
+		BWAPI::UnitType								optimal_unit = BWAPI::UnitTypes::None;
+
+		/// simulateForces() results
+		int											friendly_score = 0;
+		int											enemy_score = 0;
+
+		/// <summary> Empty every list, keeping its memory </summary>
+		void clear();
+	};
+
+	/// Streams scenarios to a file, one compact little-endian record each. A record is only written whole, so a file cut short
+	/// by a crash still reads up to its last complete record.
+	class ScenarioWriter
+	{
+	public:
+		/// <summary> Create or truncate the file and write its header. False if it can't be opened </summary>
+		bool open(const std::string& path);
+
+		bool isOpen() const;
+
+		/// <summary> Append a record of the scenario </summary>
+		void write(const Scenario& scenario);
+
+		/// <summary> Push the records written so far to the file </summary>
+		void flush();
+
+		void close();
+
+	private:
+		std::ofstream								out;
+		std::vector<unsigned char>					bytes;
+	};
+
+	/// Memory-mapped file of scenario records. Records are decoded on demand, and read() doesn't change the reader,
+	/// so threads can read records of the same file at once.
+	class ScenarioReader
+	{
+	public:
+		ScenarioReader() = default;
+		~ScenarioReader();
+
+		ScenarioReader(const ScenarioReader&) = delete;
+		ScenarioReader& operator=(const ScenarioReader&) = delete;
+
+		/// <summary> Map the file and index its records. False if it can't be mapped or isn't a scenario file </summary>
+		bool open(const std::string& path);
+
+		void close();
+
+		/// <summary> Number of complete records in the file </summary>
+		size_t size() const;
+
+		/// <summary> Decode record i into scenario, reusing its memory. False if the record is damaged </summary>
+		bool read(const size_t i, Scenario& scenario) const;
+
+	private:
+		const unsigned char*						data = nullptr;
+		size_t										length = 0;
+		std::vector<size_t>							offsets;
+
+		/// Platform handles of the mapping
+		void*										file_handle = nullptr;
+		void*										mapping_handle = nullptr;
+	};
+}
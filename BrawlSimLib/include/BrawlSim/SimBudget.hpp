@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+namespace BrawlSim
+{
+	/// How many Monte Carlo trials simulateEach() may spend over all friendly UnitTypes.
+	/// Trials are handed out in rounds. After each round a UnitType whose score interval lies entirely below the
+	/// leader's interval is dropped, and the race ends when a single UnitType is left or the budget runs out.
+	struct SimBudget
+	{
+		/// Trials over every UnitType together. 0 for no limit
+		int						total_sims = 0;
+
+		/// Wall clock time for the whole race, checked between rounds. 0 for no limit
+		std::int64_t			microseconds = 0;
+
+		/// Trials a UnitType runs before it can be dropped
+		int						min_sims = 8;
+
+		/// Most trials a single UnitType runs
+		int						max_sims = 128;
+
+		/// Half-width of the score intervals in standard errors. Larger drops UnitTypes later but more safely
+		double					z = 2.58;
+
+		/// UnitTypes whose Lanchester estimate is below this share of the best estimate aren't simmed. They are listed after every simmed
+		/// UnitType, best estimate first, with a score of 0 and 0 trials, and are never the optimal unit. 0 sims every UnitType.
+		/// Tune it with Brawl::reportPrescreen()
+		double					prune_below = 0;
+
+		SimBudget() = default;
+
+		/// Same number of trials for every UnitType, nothing is dropped
+		static SimBudget fixed(const int sims)
+		{
+			SimBudget budget;
+			budget.min_sims = sims;
+			budget.max_sims = sims;
+			return budget;
+		}
+	};
+
+	/// How far a single Brawl::step() call may advance a job started by Brawl::startEach()
+	struct StepBudget
+	{
+		/// Wall clock time of the call. Checked every few FAP frames, so it can be overrun by a little. 0 for no limit
+		std::int64_t			microseconds = 0;
+
+		/// FAP frames each running trial advances by in the call. 0 for no limit
+		int						frames = 0;
+
+		StepBudget() = default;
+		StepBudget(const std::int64_t us, const int f = 0)
+			: microseconds(us)
+			, frames(f)
+		{
+		}
+	};
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace BrawlSim
+{
+	/// Where the time of a sim call went. The times, units_killed and early_exits are only filled when BrawlSim is built
+	/// with BRAWLSIM_PROFILE defined, otherwise their timers and counters compile away and they stay 0.
+	/// Times are wall clock, so the phases run on the thread pool count once however many threads work on them.
+	struct SimProfile
+	{
+		/// Refreshing prototypes and converting UnitTypes to FAP units
+		std::int64_t			conversion_us = 0;
+
+		/// Stamping the enemy armies into the trial sims
+		std::int64_t			enemy_setup_us = 0;
+
+		/// Stamping the friendly armies into the trial sims
+		std::int64_t			friendly_setup_us = 0;
+
+		/// FAP simulating the trials
+		std::int64_t			simulate_us = 0;
+
+		/// Scoring the finished trials
+		std::int64_t			scoring_us = 0;
+
+		/// Sorting the unit ranks and picking the optimal unit
+		std::int64_t			sorting_us = 0;
+
+		/// FAP frames simulated, not counting the frames of a trial after its combat was over
+		std::int64_t			frames = 0;
+
+		/// Units of either side that died in the trials
+		std::int64_t			units_killed = 0;
+
+		/// Trials whose combat was over before the last frame, so FAP stopped early
+		int						early_exits = 0;
+
+		int						sims = 0;
+
+		SimProfile& operator+=(const SimProfile& other)
+		{
+			conversion_us += other.conversion_us;
+			enemy_setup_us += other.enemy_setup_us;
+			friendly_setup_us += other.friendly_setup_us;
+			simulate_us += other.simulate_us;
+			scoring_us += other.scoring_us;
+			sorting_us += other.sorting_us;
+			frames += other.frames;
+			units_killed += other.units_killed;
+			early_exits += other.early_exits;
+			sims += other.sims;
+			return *this;
+		}
+	};
+
+	/// Adds the time until it goes out of scope to a SimProfile field. Does nothing without BRAWLSIM_PROFILE
+	class ProfileScope
+	{
+	public:
+#ifdef BRAWLSIM_PROFILE
+		explicit ProfileScope(std::int64_t& field_us)
+			: field(field_us)
+			, start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~ProfileScope()
+		{
+			field += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+	private:
+		std::int64_t&							field;
+		std::chrono::steady_clock::time_point	start;
+#else
+		explicit ProfileScope(std::int64_t&)
+		{
+		}
+#endif
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace BrawlSim
+{
+	/// Fixed set of worker threads that split an indexed loop between them.
+	/// Workers are started once and sleep between jobs so a frame callback doesn't pay for thread creation.
+	class ThreadPool
+	{
+	public:
+		/// <param name = "threads">
+		///		Total number of threads working on a job, including the calling thread. Default is one per core.
+		/// </param>
+		explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// <summary> Run job(i) for every i in [0, count) and block until every call has returned.
+		///     The calling thread takes jobs as well. </summary>
+		template<typename Job>
+		void parallelFor(const int count, Job&& job)
+		{
+			run(count, [](void* context, int i) { (*static_cast<std::remove_reference_t<Job>*>(context))(i); }, const_cast<void*>(static_cast<const void*>(&job)));
+		}
+
+		/// <summary> Number of threads working on a job, including the calling thread </summary>
+		unsigned size() const;
+
+	private:
+		/// Function pointer and context rather than std::function, which can allocate for a large lambda
+		using JobFunction = void (*)(void*, int);
+
+		std::vector<std::thread>			workers;
+
+		std::mutex							mutex;
+		std::condition_variable				wake;
+		std::condition_variable				finished;
+
+		JobFunction							job = nullptr;
+		void*								job_context = nullptr;
+		int									job_count = 0;
+		std::atomic<int>					next_index{ 0 };
+
+		unsigned							generation = 0;
+		unsigned							active = 0;
+		bool								stopping = false;
+
+		void run(const int count, const JobFunction job_fn, void* context);
+		void workerLoop();
+		void runJobs();
+	};
+}
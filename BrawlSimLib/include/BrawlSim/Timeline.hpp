@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace BrawlSim
+{
+	/// Both sides of a trial at one frame. Health is hit points and shields together, in game units
+	struct TimelineFrame
+	{
+		int								frame = 0;
+
+		int								friendly_units = 0;
+		int								enemy_units = 0;
+
+		int								friendly_health = 0;
+		int								enemy_health = 0;
+
+		/// Health the side has taken off the other since the trial started, less what the other healed or regenerated
+		int								friendly_damage = 0;
+		int								enemy_damage = 0;
+	};
+
+	/// How simulateForces() trials record their timelines, set with Brawl::setTimeline()
+	struct TimelineOptions
+	{
+		/// Frames between snapshots. 1 takes one every frame
+		int								interval = 1;
+
+		/// Most frames a trial runs. 0 for TrialSims::trial_frames
+		int								frames = 0;
+
+		/// Snapshots kept per trial. Once full the oldest are overwritten, the first snapshot is always kept. 0 keeps all of them
+		int								capacity = 0;
+
+		/// Called with every snapshot on the thread running the trial, which ends the trial early when it returns true.
+		/// Lets a trial stop once its outcome is decided. Empty runs every trial to its end
+		std::function<bool(const TimelineFrame&)>	stop;
+	};
+
+	/// Ring buffer of the snapshots of one trial. Its memory is allocated by reset() and reused, so snapshots are taken without allocating
+	class Timeline
+	{
+	public:
+		/// <summary> Drop the snapshots and make room for new_capacity of them. Call it before the first push(). Only allocates when capacity grows </summary>
+		void reset(const int new_capacity);
+
+		/// <summary> Add a snapshot, overwriting the oldest one once the buffer is full </summary>
+		void push(const TimelineFrame& snapshot);
+
+		/// <summary> Mark the trial as ended by TimelineOptions::stop </summary>
+		void setStopped(const bool stopped);
+
+		/// <summary> Number of snapshots kept </summary>
+		int size() const;
+
+		/// <summary> Snapshot i of those kept, oldest first </summary>
+		const TimelineFrame& operator[](const int i) const;
+
+		/// <summary> Snapshot of the trial's first frame, kept once it is overwritten in the buffer </summary>
+		const TimelineFrame& first() const;
+
+		/// <summary> Latest snapshot </summary>
+		const TimelineFrame& last() const;
+
+		/// <summary> True if TimelineOptions::stop ended the trial before its combat was over </summary>
+		bool stoppedEarly() const;
+
+		/// <summary> Frame of the kept snapshot from which the side ahead at the end stayed ahead, comparing the share of its starting health
+		///     each side has left. Estimates when the fight tipped. The first snapshot's frame if neither side is ahead at the end </summary>
+		int tippingFrame() const;
+
+	private:
+		std::vector<TimelineFrame>		snapshots;
+		int								capacity = 1;
+		int								start = 0;
+		int								count = 0;
+		TimelineFrame					initial;
+		bool							stopped_early = false;
+	};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "BWAPI.h"
+#include "FAP.hpp"
+#include "FAPSoA.hpp"
+
+#include "UnitTag.hpp"
+#include "Timeline.hpp"
+
+class UnitData;
+
+namespace BrawlSim
+{
+	/// FAP backend that runs the trials. Both give identical results.
+	/// StructOfArrays keeps the fields scanned by the target searches in their own arrays, which is faster for large battles.
+	enum class SimEngine
+	{
+		ArrayOfStructs,
+		StructOfArrays
+	};
+
+	/// One FAP sim per Monte Carlo trial so trials can run on separate threads.
+	/// A trial is set up in sim(t), loaded into the selected engine, advanced in one or more steps and stored back into sim(t).
+	/// Sims are kept between calls so their buffers are reused.
+	class TrialSims
+	{
+	public:
+		/// Frames of a trial, FAP's default of 4 seconds on fastest
+		static const int									trial_frames = 96;
+
+		/// <summary> Backend and target grid threshold used by the trials loaded from now on </summary>
+		void configure(const SimEngine new_engine, const int grid_units);
+
+		/// <summary> Make sure there are at least trials sims </summary>
+		void resize(const int trials);
+
+		/// <summary> The sim a trial is set up in and its result is read from </summary>
+		FAP::FastAPproximation<UnitTag>& sim(const int t);
+
+		/// <summary> Hand a trial that has been set up in sim(t) to the selected engine </summary>
+		void load(const int t);
+
+		/// <summary> Simulate up to frames more frames of a loaded trial. Returns fewer than frames once the trial's combat is over </summary>
+		int advance(const int t, const int frames);
+
+		/// <summary> Leave the result of a finished trial in sim(t) </summary>
+		void store(const int t);
+
+		/// <summary> Load, run all trial_frames and store a trial. Returns the frames simulated before its combat was over </summary>
+		int simulate(const int t);
+
+		/// <summary> Load, run and store a trial like simulate(t), taking a snapshot into timeline every options.interval frames.
+		///     Runs options.frames frames and stops early once options.stop returns true. The timeline must have been reset() </summary>
+		int simulate(const int t, const TimelineOptions& options, Timeline& timeline);
+
+	private:
+		std::vector<FAP::FastAPproximation<UnitTag>>		sims;
+		std::vector<FAP::FastAPproximationSoA<UnitTag>>	soa_sims;
+		SimEngine											engine = SimEngine::ArrayOfStructs;
+		int													target_grid_units = 100;
+
+		TimelineFrame snapshot(const int t, const int frame, const TimelineFrame& initial) const;
+	};
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "..\BrawlSim.hpp"
+#include "../BrawlSim.hpp"
 
 class UnitData
 {
@@ -10,11 +10,28 @@ public:
 
 	int						eco_score;
 	double					survival_rate;
+	double					top_speed;
 
-	UnitData(const BWAPI::UnitType& u, const BWAPI::Player& p);
+	UnitData(const BWAPI::UnitType& u, const BWAPI::Player& p, const BrawlSim::SurvivalRates& survival_rates = BrawlSim::default_survival_rates);
 
-	/// Convert a UnitData to a FAP::Unit. Must be in header for decl(auto)
-	auto convertToFAPUnit() const
+	/// Convert a UnitData to a finished FAP::FAPUnit at (0, 0) to be copied with stampFAPUnit()
+	FAP::FAPUnit<BrawlSim::UnitTag> prototypeFAPUnit() const;
+
+	/// Copy of a prototype made by prototypeFAPUnit() with the position drawn from the trial's rng
+	FAP::FAPUnit<BrawlSim::UnitTag> stampFAPUnit(const FAP::FAPUnit<BrawlSim::UnitTag>& prototype, BrawlSim::Rng& rng) const;
+
+	inline bool operator< (const UnitData& other) const
+	{
+		return this->type.getID() < other.type.getID();
+	}
+	inline bool operator== (const UnitData& other) const
+	{
+		return this->type == other.type;
+	}
+
+private:
+	/// Every BWAPI query of the conversion. Must be in header for decl(auto)
+	auto makeFAPUnit(const BWAPI::Position& pos) const
 	{
 		int groundDamage(player->damage(type.groundWeapon()));
 		int groundCooldown(type.groundWeapon().damageFactor() && type.maxGroundHits() ? player->weaponDamageCooldown(type) / (type.groundWeapon().damageFactor() * type.maxGroundHits()) : 0);
@@ -55,78 +72,60 @@ public:
 			break;
 
 		case BWAPI::UnitTypes::Terran_Marine:
-			stimmed = player->hasResearched(BWAPI::TechTypes::Stim_Packs);
-			if (stimmed)
-			{
-				groundCooldown /= 2;
-				airCooldown /= 2;
-			}
+			stimmed = player->hasResearched(BWAPI::TechTypes::Stim_Packs); // FAP halves the cooldowns
 			break;
 		}
 
 		/// TODO - Find a way around fap flags so i can manually set upgrades
-		return FAP::makeUnit<UnitData*>()
-			.setData(const_cast<UnitData*>(this))
+		return FAP::makeUnit<BrawlSim::UnitTag>()
+			.setData(BrawlSim::UnitTag(const_cast<UnitData*>(this)))
 
 			.setUnitType(type)
-			//.setUnitSize(type.size())
+			.setUnitSize(type.size())
 
-			//.setSpeed(static_cast<float>(player->topSpeed(type)))
-			.setPosition(positionMCFAP())
+			.setSpeed(static_cast<float>(top_speed))
+			.setPosition(pos)
 			.setElevation() // default elevation -1
 
 			.setHealth(type.maxHitPoints())
-			//.setMaxHealth(type.maxHitPoints())
+			.setMaxHealth(type.maxHitPoints())
 
 			.setShields(type.maxShields())
 			.setShieldUpgrades(player->getUpgradeLevel(BWAPI::UpgradeTypes::Protoss_Plasma_Shields))
-			//.setMaxShields(type.maxShields())
-			//.setArmor(player->armor(type))
+			.setMaxShields(type.maxShields())
+			.setArmor(player->armor(type))
 
-			//.setGroundDamage(groundDamage)
-			//.setGroundCooldown(groundCooldown)
-			//.setGroundMaxRange(groundMaxRange)
-			//.setGroundMinRange(groundMinRange)
-			//.setGroundDamageType(groundDamageType)
+			.setGroundDamage(groundDamage)
+			.setGroundCooldown(groundCooldown)
+			.setGroundMaxRange(groundMaxRange)
+			.setGroundMinRange(groundMinRange)
+			.setGroundDamageType(groundDamageType)
 
-			//.setAirDamage(airDamage)
-			//.setAirCooldown(airCooldown)
-			//.setAirMaxRange(airMaxRange)
-			//.setAirMinRange(airMinRange)
-			//.setAirDamageType(airDamageType)
+			.setAirDamage(airDamage)
+			.setAirCooldown(airCooldown)
+			.setAirMaxRange(airMaxRange)
+			.setAirMinRange(airMinRange)
+			.setAirDamageType(airDamageType)
 
 			.setAttackerCount(attackerCount)
 			.setStimmed(stimmed)
 
 			.setFlying(type.isFlyer())
-			//.setOrganic(type.isOrganic())
+			.setOrganic(type.isOrganic())
 
 			// Already calculated above but have to .set for FAP Flags. Might disable the FAP Flags later
-			.setSpeedUpgrade(NULL)
-			.setArmorUpgrades(NULL)
-			.setAttackUpgrades(NULL)
-			.setAttackSpeedUpgrade(NULL)
-			.setAttackCooldownRemaining(NULL)
-			.setRangeUpgrade(NULL)
+			.setSpeedUpgrade(false)
+			.setArmorUpgrades(0)
+			.setAttackUpgrades(0)
+			.setAttackSpeedUpgrade(false)
+			.setAttackCooldownRemaining(0)
+			.setRangeUpgrade(false)
 			;
 	}
 
-	inline bool operator< (const UnitData& other) const
-	{
-		return this->type.getID() < other.type.getID();
-	}
-	inline bool operator== (const UnitData& other) const
-	{
-		return this->type == other.type;
-	}
-
-private:
 	/// Return a map of valid simmable UnitTypes and a starting economic-based score
 	int initialEcoScore() const;
 
 	/// Generate a random position for the unit based on the unit speed
-	BWAPI::Position positionMCFAP() const;
-
-	/// Get the hardcoded survival rate of a unit. Taken from http://basil.bytekeeper.org/stats.html (5/2/19).
-	double survivalScore() const;
-};
\ No newline at end of file
+	BWAPI::Position positionMCFAP(BrawlSim::Rng& rng) const;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "BWAPI.h"
+
+namespace BrawlSim
+{
+	/// How one unit of a simulateForces() force fared over every Monte Carlo trial
+	struct UnitOutcome
+	{
+		BWAPI::UnitType			type = BWAPI::UnitTypes::None;
+
+		/// Fraction of the trials the unit survived
+		double					survival_rate = 0;
+
+		/// Mean fraction of its starting hit points and shields the unit lost. A trial it died in counts as 1
+		double					hp_lost = 0;
+	};
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "BWAPI.h"
+
+namespace BrawlSim
+{
+	/// Running mean and variance of trial scores (Welford's algorithm)
+	struct RunningStats
+	{
+		int						count = 0;
+		double					mean = 0;
+		double					m2 = 0;
+
+		void add(const double x)
+		{
+			++count;
+			double delta = x - mean;
+			mean += delta / count;
+			m2 += delta * (x - mean);
+		}
+
+		/// Sample variance of the scores added so far. 0 until there are two samples
+		double variance() const
+		{
+			return count > 1 ? m2 / (count - 1) : 0;
+		}
+	};
+
+	/// Score of a friendly UnitType over every Monte Carlo trial it was simmed in
+	struct UnitRank
+	{
+		BWAPI::UnitType			type = BWAPI::UnitTypes::None;
+		double					score = 0;
+		double					variance = 0;
+		int						sims = 0;
+
+		UnitRank() = default;
+		UnitRank(const BWAPI::UnitType& t, const double s, const double v = 0, const int n = 0)
+			: type(t)
+			, score(s)
+			, variance(v)
+			, sims(n)
+		{
+		}
+	};
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+
+#include "BWAPI.h"
+
+namespace BrawlSim
+{
+	/// Survival rate of each UnitType, indexed by UnitType ID. Scoring type 0 starts a UnitType's score at its rate
+	using SurvivalRates = std::array<double, BWAPI::UnitTypes::Enum::MAX>;
+
+	/// UnitType a unit is morphed or merged from and how many of it. Their cost is part of the unit's eco score
+	struct MorphSource
+	{
+		BWAPI::UnitTypes::Enum::Enum	type = BWAPI::UnitTypes::Enum::None;
+		int								count = 0;
+	};
+
+	using MorphSources = std::array<MorphSource, BWAPI::UnitTypes::Enum::MAX>;
+
+	/// Survival rates from http://basil.bytekeeper.org/stats.html (5/2/19). 0 for UnitTypes without stats
+	constexpr SurvivalRates makeDefaultSurvivalRates()
+	{
+		namespace Types = BWAPI::UnitTypes::Enum;
+
+		// Rate = (Created - Destroyed) / Created
+		const auto rate = [](const double created, const double destroyed) { return (created - destroyed) / created; };
+
+		SurvivalRates rates{};
+		rates[Types::Zerg_Zergling] = rate(3006333, 2406700);
+		rates[Types::Zerg_Scourge] = rate(91936, 84880);
+		rates[Types::Zerg_Hydralisk] = rate(596532, 375965);
+		rates[Types::Zerg_Mutalisk] = rate(332894, 163463);
+		rates[Types::Zerg_Lurker] = rate(81650, 51993);
+		rates[Types::Zerg_Guardian] = rate(6206, 2406);
+		rates[Types::Zerg_Devourer] = rate(1353, 680);
+		rates[Types::Zerg_Ultralisk] = rate(11769, 5016);
+
+		rates[Types::Protoss_Zealot] = rate(1184533, 848823);
+		rates[Types::Protoss_Dragoon] = rate(793539, 475569);
+		rates[Types::Protoss_Dark_Templar] = rate(80670, 45363);
+		rates[Types::Protoss_Corsair] = rate(39440, 21326);
+		rates[Types::Protoss_Scout] = rate(1961, 1125);
+		rates[Types::Protoss_Reaver] = rate(35619, 18228);
+		rates[Types::Protoss_Arbiter] = rate(7139, 1682);
+		rates[Types::Protoss_Archon] = rate(10652, 5803);
+		rates[Types::Protoss_Carrier] = rate(52100, 10046);
+
+		rates[Types::Terran_Marine] = rate(1552978, 1175725);
+		rates[Types::Terran_Medic] = rate(165745, 99173);
+		rates[Types::Terran_Firebat] = rate(77668, 58791);
+		rates[Types::Terran_Ghost] = rate(15923, 10122);
+		rates[Types::Terran_Vulture] = rate(802517, 583869);
+		rates[Types::Terran_Goliath] = rate(250987, 158862);
+		rates[Types::Terran_Siege_Tank_Siege_Mode] = rate(381571, 51902);
+		rates[Types::Terran_Siege_Tank_Tank_Mode] = rate(381571, 51902);
+		rates[Types::Terran_Wraith] = rate(66741, 38469);
+		rates[Types::Terran_Valkyrie] = rate(7764, 4525);
+		rates[Types::Terran_Battlecruiser] = rate(10447, 3793);
+		return rates;
+	}
+
+	constexpr MorphSources makeMorphSources()
+	{
+		namespace Types = BWAPI::UnitTypes::Enum;
+
+		MorphSources sources{};
+		sources[Types::Zerg_Lurker] = { Types::Zerg_Hydralisk, 1 };
+		sources[Types::Zerg_Devourer] = { Types::Zerg_Mutalisk, 1 };
+		sources[Types::Zerg_Guardian] = { Types::Zerg_Mutalisk, 1 };
+		sources[Types::Protoss_Archon] = { Types::Protoss_High_Templar, 2 };
+		sources[Types::Protoss_Dark_Archon] = { Types::Protoss_Dark_Templar, 2 };
+		return sources;
+	}
+
+	constexpr SurvivalRates default_survival_rates = makeDefaultSurvivalRates();
+	constexpr MorphSources morph_sources = makeMorphSources();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+class UnitData;
+
+namespace BrawlSim
+{
+	/// Extension every FAP unit of a sim carries: the UnitData it was converted from and an id that stays with the unit
+	/// however FAP reorders its vectors. Marines a dying Bunker leaves behind keep the Bunker's id.
+	struct UnitTag
+	{
+		UnitData*				unit_data = nullptr;
+
+		/// Index of the unit in the order it was added to the sim, -1 where the caller doesn't track units
+		int						id = -1;
+
+		UnitTag() = default;
+		UnitTag(UnitData* data, const int unit_id = -1)
+			: unit_data(data)
+			, id(unit_id)
+		{
+		}
+
+		UnitData* operator->() const
+		{
+			return unit_data;
+		}
+
+		UnitData& operator*() const
+		{
+			return *unit_data;
+		}
+
+		bool operator==(const UnitTag& other) const
+		{
+			return unit_data == other.unit_data && id == other.id;
+		}
+
+		bool operator!=(const UnitTag& other) const
+		{
+			return !(*this == other);
+		}
+	};
+}
@@ -0,0 +1,104 @@
+#include "../../BrawlSimLib/include/BrawlSim/AsyncRace.hpp"
+
+namespace BrawlSim
+{
+	AsyncRace::AsyncRace(const unsigned threads)
+		: pool(threads)
+		, race(pool)
+		, worker(&AsyncRace::workerLoop, this)
+	{
+	}
+
+	AsyncRace::~AsyncRace()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		worker.join();
+	}
+
+	/// The worker only holds the lock to take the input, so this doesn't wait for a running race
+	void AsyncRace::start(RaceInput&& input, const std::uint64_t job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending = std::move(input);
+			pending_job = job;
+			has_pending = true;
+		}
+		wake.notify_one();
+	}
+
+	/// The worker sees the flag after its current slice and goes back to waiting for a race
+	void AsyncRace::cancel()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.clear();
+		has_pending = false;
+		cancelled = true;
+	}
+
+	bool AsyncRace::poll()
+	{
+		return results.update();
+	}
+
+	const AsyncRace::Result& AsyncRace::result() const
+	{
+		return results.front();
+	}
+
+	void AsyncRace::workerLoop()
+	{
+		for (;;)
+		{
+			RaceInput input;
+			std::uint64_t job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return stopping || has_pending; });
+				if (stopping)
+				{
+					return;
+				}
+				input = std::move(pending);
+				job = pending_job;
+				has_pending = false;
+				cancelled = false;
+			}
+
+			race.start(std::move(input));
+			publish(job);
+
+			// Run in slices so a new race, a cancel or a stop is picked up quickly. Partial ranks are published after every slice
+			while (!race.step(StepBudget(slice_microseconds)))
+			{
+				if (stopping || has_pending || cancelled)
+				{
+					break;
+				}
+				publish(job);
+			}
+			if (race.isDone())
+			{
+				publish(job);
+			}
+		}
+	}
+
+	/// Copy the race's ranks into the back slot and hand it to the game thread
+	void AsyncRace::publish(const std::uint64_t job)
+	{
+		Result& result = results.back();
+		result.ranks = race.ranks();
+		result.optimal_unit = race.optimalUnit();
+		result.sims = race.simCount();
+		result.frames = race.frameCount();
+		result.profile = race.profile();
+		result.done = race.isDone();
+		result.job = job;
+		results.publish();
+	}
+}
@@ -1,7 +1,17 @@
-#include "..\..\BrawlSimLib\include\BrawlSim.hpp"
+#include "../../BrawlSimLib/include/BrawlSim.hpp"
 
 namespace BrawlSim
 {
+	Brawl::Brawl()
+		: Brawl(liveGame())
+	{
+	}
+
+	Brawl::Brawl(GameContext& game_context)
+		: game(&game_context)
+	{
+	}
+
 	// @TODO: Check to make sure all unsimmable unittypes are removed and that all simmable are included (abilities simmable?)
 	/// Checks if a UnitType is a suitable type for the sim
 	bool Brawl::isValidType(const BWAPI::UnitType& type)
@@ -23,370 +33,1040 @@ namespace BrawlSim
 			type == BWAPI::UnitTypes::Terran_Medic;
 	}
 
-	/// Scale enemy unit composition and add the enemy types to the sim
-	void Brawl::addEnemyTypes(const BWAPI::Unitset& units, const BWAPI::UnitType& friendly_type, int army_size)
+	/// One UnitType per unit of the set, written to types
+	const std::vector<BWAPI::UnitType>& Brawl::unitTypes(const BWAPI::Unitset& units, std::vector<BWAPI::UnitType>& types)
+	{
+		types.clear();
+		for (const auto& u : units)
+		{
+			types.push_back(u->getType());
+		}
+		return types;
+	}
+
+	/// Build the enemy composition once per simulation and scale it to army_size
+	void Brawl::buildEnemyData(const std::vector<BWAPI::UnitType>& types, int army_size)
 	{
-		if (enemy_data.empty()) // only build enemy data once
+		for (const auto& type : types) //count unittypes
 		{
-			int unit_total = 0;
-			for (const auto& u : units) //count unittypes
+			if (isValidType(type))
 			{
-				if (isValidType(u->getType()))
-				{
-					UnitData temp = UnitData(u->getType(), BWAPI::Broodwar->enemy());
-					enemy_data[temp]++;
-					enemy_score += temp.eco_score;
-					++unit_total;
-				}
+				const UnitData& temp = prototypes.data(type, game->enemy());
+				enemy_data.add(temp);
+				enemy_score += temp.eco_score;
 			}
-			if (army_size != -1) // if army_size == -1 no scaling
-			{
-				for (const auto& ut : enemy_data)
-				{
-					double percent = ut.second / (double)unit_total;
-					int scaled_count = std::lround(percent * army_size);
+		}
+		if (army_size != -1) // if army_size == -1 no scaling
+		{
+			enemy_data.scale(army_size);
+		}
+	}
 
-					enemy_data[ut.first] = scaled_count;
-				}
-			}
+	/// Check if the friendly type can attack any of the enemy units in the sim
+	bool Brawl::canAttackEnemies(const BWAPI::UnitType& friendly_type) const
+	{
+		return (friendly_type.maxAirHits() && enemy_data.hasAir()) || (friendly_type.maxGroundHits() && enemy_data.hasGround());
+	}
+
+	/// Number of friendly units needed for the friendly score to match the enemy score
+	int Brawl::friendlyArmySize(const UnitData& data) const
+	{
+		int score = 0;
+		int army_size = 0;
+		while (score < enemy_score)
+		{
+			score += data.eco_score;
+			++army_size;
 		}
 
-		int attack_count = 0;
-		valid_enemies = true;
-		for (auto& u : enemy_data)
+		if (score < enemy_score - (data.eco_score / 4)) // Add one more unit to friendly sim if scores aren't very even
 		{
-			if ((friendly_type.maxAirHits() && u.first.type.isFlyer()) || (friendly_type.maxGroundHits() && !u.first.type.isFlyer()))
-			{
-				attack_count++;
-			}
-			for (int i = 0; i < u.second; ++i)
-			{
-				MCfap.addUnitPlayer2(u.first.convertToFAPUnit());
-			}
+			++army_size;
 		}
-		if (attack_count == 0) //the friendly type can't attack any of the enemy units in the sim
+		return army_size;
+	}
+
+	/// UnitData and starting hit points of each unit id of a force, taken from a trial before it runs
+	void Brawl::trackUnits(const std::vector<FAP::FAPUnit<UnitTag>>& units, std::vector<ForceUnit>& start)
+	{
+		start.resize(units.size());
+		for (const auto& fu : units)
 		{
-			unit_ranks.push_back(std::make_pair(friendly_type, 0));
-			valid_enemies = false;
+			start[fu.data.id] = { fu.data.unit_data, fu.health + fu.shields };
 		}
 	}
 
-	/// Add valid friendly units to the FAP sim and score them. Return map of the UnitType and score
-	void Brawl::addFriendlyType(const BWAPI::UnitType& type, int& army_size)
+	/// Write the hit points and shields left of every unit id to hp, then return the eco score of the ids with no survivor.
+	/// Ids follow the units however FAP reorders them, so the units don't need to be matched against a copy taken before the sim
+	int Brawl::tallySurvivors(const std::vector<FAP::FAPUnit<UnitTag>>& units, const std::vector<ForceUnit>& start, int* hp)
 	{
-		friendly_data.push_back(UnitData(type, BWAPI::Broodwar->self()));
+		std::fill(hp, hp + start.size(), 0);
+		for (const auto& fu : units)
+		{
+			hp[fu.data.id] += fu.health + fu.shields;
+		}
 
-		army_size = 0;
-		if (type.isTwoUnitsInOneEgg()) //zerglings and scourges
+		int lost = 0;
+		for (size_t id = 0; id < start.size(); ++id)
 		{
-			while (friendly_score < enemy_score) // add double the units
+			if (hp[id] == 0)
 			{
-				for (int i = 0; i < 2; i++)
-				{
-					MCfap.addUnitPlayer1(std::move(friendly_data.back().convertToFAPUnit()));
-				}
-				friendly_score += friendly_data.back().eco_score;
-				++army_size;
+				lost += start[id].data->eco_score;
 			}
 		}
-		else
+		return lost;
+	}
+
+	/// Average every unit id's survivals and hit point loss over the trials. hp holds a row of start.size() ids per trial
+	void Brawl::setOutcomes(const std::vector<ForceUnit>& start, const std::vector<int>& hp, const int trials, std::vector<UnitOutcome>& outcomes)
+	{
+		outcomes.resize(start.size());
+		for (size_t id = 0; id < start.size(); ++id)
 		{
-			while (friendly_score < enemy_score)
+			UnitOutcome& outcome = outcomes[id];
+			outcome.type = start[id].data->type;
+			outcome.survival_rate = 0;
+			outcome.hp_lost = 0;
+			for (int t = 0; t < trials; ++t)
 			{
-				MCfap.addUnitPlayer1(std::move(friendly_data.back().convertToFAPUnit()));
-				friendly_score += friendly_data.back().eco_score;
-				++army_size;
+				const int left = hp[t * start.size() + id];
+				outcome.survival_rate += left > 0;
+				outcome.hp_lost += std::max(1 - left / static_cast<double>(start[id].start_hp), 0.0); // A Bunker's marines can have more than it
 			}
+			outcome.survival_rate /= trials;
+			outcome.hp_lost /= trials;
 		}
+	}
 
-		if (friendly_score < enemy_score - (friendly_data.back().eco_score / 4)) // Add one more unit to friendly sim if scores aren't very even
+	/// Starting score of a UnitData for the scoring type
+	double Brawl::initialScore(const UnitData& data, const int scoring_type) const
+	{
+		switch (scoring_type)
 		{
-			MCfap.addUnitPlayer1(std::move(friendly_data.back().convertToFAPUnit()));
-			friendly_score += friendly_data.back().eco_score;
-			++army_size;
+		case 0:
+			return data.survival_rate;
+		case 1:
+			return data.eco_score;
+		case 2:
+			return 1;
 		}
+		return 0;
 	}
 
-	void Brawl::checkAliveUnits(std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& friendly_pre_units, std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& enemy_pre_units)
+	/// Simulate each friendly UnitType against the composition of enemy units
+	void Brawl::simulateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const int scoring_type, int army_size, const int sims)
 	{
-		checkAliveFriendly(friendly_pre_units);
-		checkAliveEnemy(enemy_pre_units);
+		simulateEach(friendly_types, unitTypes(enemy_units, enemy_type_buffer), SimBudget::fixed(std::max(sims, 1)), scoring_type, army_size);
 	}
 
-	void Brawl::checkAliveFriendly(std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& friendly_pre_units)
+	void Brawl::simulateEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const int scoring_type, int army_size, const int sims)
 	{
-		size_t i = 0, j = 0;
-		while (i < MCfap.getState().first->size())
+		simulateEach(friendly_types, enemy_types, SimBudget::fixed(std::max(sims, 1)), scoring_type, army_size);
+	}
+
+	/// Race the friendly UnitTypes against the composition of enemy units within a trial budget
+	void Brawl::simulateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		simulateEach(friendly_types, unitTypes(enemy_units, enemy_type_buffer), budget, scoring_type, army_size);
+	}
+
+	void Brawl::simulateEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		startEach(friendly_types, enemy_types, budget, scoring_type, army_size);
+		while (!step())
+		{
+		}
+	}
+
+	/// Refresh the prototypes and build the scaled enemy composition of a simulateEach() race
+	void Brawl::convertEnemies(const std::vector<BWAPI::UnitType>& enemy_types, int army_size)
+	{
+		ProfileScope scope(profile.conversion_us);
+		prototypes.refresh(game->self());
+		prototypes.refresh(game->enemy());
+		buildEnemyData(enemy_types, army_size); //Build enemy unit data once for every friendly type
+	}
+
+	/// Convert the units of a simulateEach() race after convertEnemies(). Every BWAPI query of the race happens here, on the game thread
+	void Brawl::makeRaceInput(RaceInput& input, const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type)
+	{
+		ProfileScope scope(profile.conversion_us);
+		input.budget = budget;
+		input.seed = seed;
+		input.engine = engine;
+		input.target_grid_units = target_grid_units;
+
+		//Return best initial score if there are no enemy units to sim against
+		if (enemy_types.empty())
 		{
-			// Unit died
-			if (MCfap.getState().first->at(i).data != friendly_pre_units.at(j).first.data)
+			for (auto& type : friendly_types)
 			{
-				friendly_score -= friendly_pre_units.at(j).first.data->eco_score;
-				friendly_pre_units.at(j).second = 0;
-				++j;
+				if (isValidType(type) && type.maxGroundHits()) //Dont consider units that can only shoot air initially
+				{
+					input.unraced_ranks.push_back(UnitRank(type, initialScore(prototypes.data(type, game->self()), scoring_type)));
+				}
 			}
-			// Unit alive
-			else
+			return;
+		}
+
+		for (const auto& u : enemy_data)
+		{
+			input.enemies.push_back({ input.own(*u.data, prototypes.prototype(u.data->type, u.data->player)), u.count });
+		}
+
+		for (auto& type : friendly_types)  //simming each type against the enemy
+		{
+			if (isValidType(type))
 			{
-				++i;
-				++j;
+				if (!canAttackEnemies(type)) //the friendly type can't attack any of the enemy units in the sim
+				{
+					input.unraced_ranks.push_back(UnitRank(type, 0));
+					continue;
+				}
+
+				const UnitData& data = prototypes.data(type, game->self());
+				input.contenders.push_back({ input.own(data, prototypes.prototype(type, game->self())), friendlyArmySize(data), initialScore(data, scoring_type), RunningStats() }); //As many types as enemy score allows for even sim
 			}
 		}
-		for (j; j < friendly_pre_units.size(); ++j)
+
+		if (budget.prune_below > 0)
 		{
-			friendly_score -= friendly_pre_units.at(j).first.data->eco_score;
+			prescreen(input);
 		}
 	}
 
-	void Brawl::checkAliveEnemy(std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>>& enemy_pre_units)
+	/// Don't race the contenders whose Lanchester estimate is far below the best one. The estimate isn't comparable to a FAP score,
+	/// so they are only ordered by it among themselves, below every raced UnitType
+	void Brawl::prescreen(RaceInput& input)
 	{
-		size_t i = 0, j = 0;
-		while (i < MCfap.getState().second->size())
+		estimates.clear();
+		double best = 0;
+		for (const auto& contender : input.contenders)
 		{
-			// Unit died
-			if (MCfap.getState().second->at(i).data != enemy_pre_units.at(j).first.data)
+			estimates.push_back(lanchesterScore(contender, input.enemies));
+			best = std::max(best, estimates.back());
+		}
+		if (best <= 0)
+		{
+			return;
+		}
+
+		pruned.clear();
+		size_t kept = 0;
+		for (size_t i = 0; i < input.contenders.size(); ++i)
+		{
+			// The best estimate is always raced, whatever prune_below is
+			if (estimates[i] >= std::min(input.budget.prune_below, 1.0) * best)
 			{
-				enemy_score -= enemy_pre_units.at(j).first.data->eco_score;
-				enemy_pre_units.at(j).second = 0;
-				++j;
+				input.contenders[kept++] = input.contenders[i];
 			}
-			// Unit alive
 			else
 			{
-				++i;
-				++j;
+				pruned.push_back(std::make_pair(estimates[i], input.contenders[i].prototype.data->type));
 			}
 		}
-		for (j; j < enemy_pre_units.size(); ++j)
+		input.contenders.erase(input.contenders.begin() + kept, input.contenders.end());
+
+		std::stable_sort(pruned.begin(), pruned.end(), [](const std::pair<double, BWAPI::UnitType>& lhs, const std::pair<double, BWAPI::UnitType>& rhs)
+		{
+			return lhs.first > rhs.first;
+		});
+		for (const auto& p : pruned)
 		{
-			enemy_score -= enemy_pre_units.at(j).first.data->eco_score;
+			input.pruned_ranks.push_back(UnitRank(p.second, 0));
 		}
 	}
 
-	/// Updates the UnitData's score to post FAP sim values
-	void Brawl::setPostRank(const int scoring_type, const int army_size)
+	/// Compare the Lanchester estimates of a race to its FAP scores
+	PrescreenReport Brawl::reportPrescreen(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size)
 	{
-		double initial_score = 0;
-		switch (scoring_type)
+		SimBudget full = budget;
+		full.prune_below = 0;
+		simulateEach(friendly_types, enemy_types, full, scoring_type, army_size);
+
+		PrescreenReport report;
+		if (enemy_types.empty())
 		{
-		case 0:
-			initial_score = friendly_data.back().survival_rate;
-			break;
-		case 1:
-			initial_score = friendly_data.back().eco_score;
-			break;
-		case 2:
-			initial_score = 1;
-			break;
+			return report;
 		}
 
-		double res_score = 0;
-		int i = 0;
-		// Accumulate total score for the unittype and increment the count;
-		for (auto& fu : *MCfap.getState().first)
+		// Same contenders as the race, the enemy composition is still the race's
+		report_input.clear();
+		makeRaceInput(report_input, friendly_types, enemy_types, full, scoring_type);
+		for (const auto& contender : report_input.contenders)
 		{
-			double proportion_health = (fu.health + fu.shields) / (double)(fu.maxHealth + fu.maxShields);
+			for (const auto& rank : unit_ranks)
+			{
+				if (rank.type == contender.prototype.data->type && rank.sims > 0)
+				{
+					report.entries.push_back({ rank.type, lanchesterScore(contender, report_input.enemies), rank.score, rank.sims });
+					break;
+				}
+			}
+		}
+		if (report.entries.empty())
+		{
+			return report;
+		}
 
-			res_score = (i * res_score + (proportion_health * initial_score)) / (double)(i + 1);
-			++i;
+		std::stable_sort(report.entries.begin(), report.entries.end(), [](const PrescreenEntry& lhs, const PrescreenEntry& rhs)
+		{
+			return lhs.score > rhs.score;
+		});
+
+		// Rank of each entry by its estimate
+		const int n = static_cast<int>(report.entries.size());
+		std::vector<int> order(n);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](const int lhs, const int rhs)
+		{
+			return report.entries[lhs].estimate > report.entries[rhs].estimate;
+		});
+
+		double squared_rank_difference = 0;
+		for (int r = 0; r < n; ++r)
+		{
+			squared_rank_difference += static_cast<double>(order[r] - r) * (order[r] - r);
 		}
-		for (i; i < army_size; ++i) //size discrepancy, these units died in sim
+		for (const auto& entry : report.entries)
 		{
-			res_score = (i * res_score) / (double)(i + 1);
+			report.mean_error += std::abs(entry.estimate - entry.score) / n;
 		}
-		unit_ranks.push_back(std::make_pair(friendly_data.back().type, res_score));
+		report.rank_correlation = n > 1 ? 1 - 6 * squared_rank_difference / (static_cast<double>(n) * (static_cast<double>(n) * n - 1)) : 1;
+
+		const double best_estimate = report.entries[order.front()].estimate;
+		report.winner_ratio = best_estimate > 0 ? report.entries.front().estimate / best_estimate : 1;
+		return report;
 	}
 
-	/// Sort in descending order
-	void Brawl::sortRanks()
+	/// Set up the simulateEach() race without running any trials
+	void Brawl::startEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type, int army_size)
 	{
-		sort(unit_ranks.begin(), unit_ranks.end(), [&](std::pair<BWAPI::UnitType, double>& lhs, std::pair<BWAPI::UnitType, double>& rhs)
+		startEach(friendly_types, unitTypes(enemy_units, enemy_type_buffer), budget, scoring_type, army_size);
+	}
+
+	void Brawl::startEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		startRace(friendly_types, enemy_types, budget, scoring_type, army_size, false);
+	}
+
+	/// Set up a race that carries over the trials of the last one
+	void Brawl::startUpdate(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		startUpdate(friendly_types, unitTypes(enemy_units, enemy_type_buffer), budget, scoring_type, army_size);
+	}
+
+	void Brawl::startUpdate(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		startRace(friendly_types, enemy_types, budget, scoring_type, army_size, true);
+	}
+
+	void Brawl::updateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		updateEach(friendly_types, unitTypes(enemy_units, enemy_type_buffer), budget, scoring_type, army_size);
+	}
+
+	void Brawl::updateEach(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		startUpdate(friendly_types, enemy_types, budget, scoring_type, army_size);
+		while (!step())
 		{
-			return lhs.second > rhs.second;
-		});
+		}
+	}
+
+	void Brawl::startRace(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size, const bool carry_over)
+	{
+		resetFlags();
+		resetData();
+
+		//Optimal is BWAPI::UnitType::None if no simmable friendly UnitData
+		if (friendly_types.empty())
+		{
+			return;
+		}
+
+		convertEnemies(enemy_types, army_size);
+
+		// The composition this race is simmed against, kept for the next update once the race is done
+		pending_key = updateKey(scoring_type, army_size);
+		pending_enemies.clear();
+		for (const auto& group : enemy_data)
+		{
+			pending_enemies.push_back(std::make_pair(group.data->type.getID(), group.count));
+		}
+		update_pending = true;
+
+		if (result_cache.enabled() && !carry_over)
+		{
+			cache_key = eachKey(friendly_types, enemy_types, budget, scoring_type, army_size);
+			if (const CachedResult* cached = result_cache.find(cache_key, game->frameCount()))
+			{
+				restoreResult(*cached);
+				simEachFlag = true;
+				finishRace();
+				return;
+			}
+			cache_pending = true;
+		}
+
+		// Filled in place so the race's input keeps its memory between calls
+		RaceInput& input = race.prepare();
+		makeRaceInput(input, friendly_types, enemy_types, budget, scoring_type);
+		if (carry_over)
+		{
+			carryOver(input);
+		}
+		else if (recorder)
+		{
+			beginRecord(Scenario::Kind::Each, enemy_types);
+			record.friendly_types.assign(friendly_types.begin(), friendly_types.end());
+			record.budget = budget;
+			record.scoring_type = scoring_type;
+			record.army_size = army_size;
+			for (const auto& contender : input.contenders)
+			{
+				recordPrototype(contender.prototype, 0);
+			}
+			for (const auto& group : input.enemies)
+			{
+				recordPrototype(group.prototype, 1);
+			}
+			record_pending = true;
+		}
+		race.start();
+		publishRanks();
+		if (race.isDone())
+		{
+			finishRace();
+		}
 	}
 
-	/// Set the optimal unit to the friendly UnitType with the highest score. If scores are tied, chooses more "flexible" UnitType.
-	void Brawl::setOptimalUnit()
+	/// Seed the contenders with the trials of the last finished race, weighted by how much of the enemy composition is unchanged
+	void Brawl::carryOver(RaceInput& input) const
 	{
-		double best_sim_score = INT_MIN;
-		BWAPI::UnitType res = BWAPI::UnitTypes::None;
+		if (update_ranks.empty() || update_key != pending_key || input.contenders.empty())
+		{
+			return;
+		}
 
-		// ranks are sorted so just check scores that are equal to the first unit's score
-		for (const auto& u : unit_ranks)
+		const auto countOf = [](const std::vector<std::pair<int, int>>& groups, const int id)
 		{
-			// there are several cases where the test return ties, ex: cannot see enemy units and they appear "empty", extremely one-sided combat...
-			if (u.second > best_sim_score)
+			for (const auto& group : groups)
 			{
-				best_sim_score = u.second;
-				res = u.first;
+				if (group.first == id)
+				{
+					return group.second;
+				}
 			}
-			// there are several cases where the t est return ties, ex: cannot see enemy units and they appear "empty", extremely one-sided combat...
-			else if (u.second == best_sim_score)
+			return 0;
+		};
+		int changed = 0;
+		int old_total = 0;
+		int new_total = 0;
+		for (const auto& group : pending_enemies)
+		{
+			changed += std::abs(group.second - countOf(update_enemies, group.first));
+			new_total += group.second;
+		}
+		for (const auto& group : update_enemies)
+		{
+			changed += countOf(pending_enemies, group.first) == 0 ? group.second : 0;
+			old_total += group.second;
+		}
+		const double kept = 1.0 - static_cast<double>(changed) / std::max({ old_total, new_total, 1 });
+		if (kept <= 0)
+		{
+			return;
+		}
+
+		for (auto& contender : input.contenders)
+		{
+			for (const auto& rank : update_ranks)
 			{
-				// if the current unit is "flexible" with regard to air and ground units, then keep it and continue to consider the next unit.
-				if (res.airWeapon() != BWAPI::WeaponTypes::None && res.groundWeapon() != BWAPI::WeaponTypes::None)
+				if (rank.type != contender.prototype.data->type || rank.sims == 0)
 				{
 					continue;
 				}
-				// if the tying unit is "flexible", then let's use that one.
-				else if (u.first.airWeapon() != BWAPI::WeaponTypes::None && u.first.groundWeapon() != BWAPI::WeaponTypes::None)
+				// Leave room for new trials within max_sims
+				const int count = std::min(static_cast<int>(std::lround(rank.sims * kept)), std::max(input.budget.max_sims, 1) - 1);
+				if (count > 0)
 				{
-					res = u.first;
+					contender.prior.count = count;
+					contender.prior.mean = rank.score;
+					contender.prior.m2 = rank.variance * (count - 1);
 				}
-			}
-			// Scores are getting lower, return what we have
-			else
-			{
-				optimal_unit = res;
+				break;
 			}
 		}
 	}
 
-	/// Simulate each friendly UnitType against the composition of enemy units
-	void Brawl::simulateEach(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const int scoring_type, int army_size, const int sims)
+	/// Keep the result of a finished race for the cache and the next update
+	void Brawl::finishRace()
+	{
+		cacheResult();
+		if (update_pending)
+		{
+			update_pending = false;
+			update_ranks = unit_ranks;
+			update_enemies.swap(pending_enemies);
+			update_key = pending_key;
+		}
+		if (record_pending)
+		{
+			record_pending = false;
+			record.ranks = unit_ranks;
+			record.optimal_unit = optimal_unit;
+			recorder->write(record);
+		}
+	}
+
+	/// Run the started race until it is done or the step budget is used up
+	bool Brawl::step(const StepBudget& step_budget)
+	{
+		if (race.isDone())
+		{
+			return true;
+		}
+		const bool done = race.step(step_budget);
+		publishRanks();
+		if (done)
+		{
+			finishRace();
+		}
+		return done;
+	}
+
+	bool Brawl::isDone() const
+	{
+		return race.isDone();
+	}
+
+	/// Make the ranks of the trials run so far available to getUnitRanks()
+	void Brawl::publishRanks()
+	{
+		unit_ranks = race.ranks();
+		optimal_unit = race.optimalUnit();
+		sims_run = race.simCount();
+		frames_run = race.frameCount();
+		simEachFlag = true;
+	}
+
+	/// Hand the race to the background thread. Only the conversion runs here
+	void Brawl::startAsync(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const SimBudget& budget, const int scoring_type, int army_size)
+	{
+		startAsync(friendly_types, unitTypes(enemy_units, enemy_type_buffer), budget, scoring_type, army_size);
+	}
+
+	void Brawl::startAsync(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, int army_size)
 	{
 		resetFlags();
-		unit_ranks.reserve(friendly_types.size());
-		friendly_data.reserve(friendly_types.size());
+		resetData();
 
 		//Optimal is BWAPI::UnitType::None if no simmable friendly UnitData
 		if (friendly_types.empty())
 		{
 			return;
 		}
-		//Return best initial score if there are no enemy units to sim against
-		else if (enemy_units.empty())
+
+		if (!async_race)
 		{
-			for (auto& type : friendly_types)
-			{
-				if (isValidType(type) && type.maxGroundHits()) //Dont consider units that can only shoot air initially
-				{
-					friendly_data.push_back(UnitData(type, BWAPI::Broodwar->self()));
+			// Leave a core for the game thread
+			async_race.reset(new AsyncRace(std::max(std::thread::hardware_concurrency(), 2u) - 1));
+		}
+		RaceInput input;
+		convertEnemies(enemy_types, army_size);
+		makeRaceInput(input, friendly_types, enemy_types, budget, scoring_type);
+		async_race->start(std::move(input), ++async_job);
+		async_done = false;
+	}
 
-					switch (scoring_type)
-					{
-					case 0:
-						unit_ranks.push_back(std::make_pair(type, friendly_data.back().survival_rate));
-						break;
-					case 1:
-						unit_ranks.push_back(std::make_pair(type, friendly_data.back().eco_score));
-						break;
-					case 2:
-						unit_ranks.push_back(std::make_pair(type, 1));
-						break;
-					}
-				}
-				sortRanks();
-				setOptimalUnit();
-			}
+	/// Copy the latest ranks of the background race if they belong to the last startAsync()
+	bool Brawl::pollAsync()
+	{
+		if (!async_race || !async_race->poll())
+		{
+			return false;
 		}
-		else
+
+		const AsyncRace::Result& result = async_race->result();
+		if (result.job != async_job || async_done)
 		{
-			for (auto& type : friendly_types)  //simming each type against the enemy
-			{
-				if (isValidType(type))
-				{
-					addEnemyTypes(enemy_units, type, army_size); //Build enemy unit data and add to sim
+			return false;
+		}
+		unit_ranks = result.ranks;
+		optimal_unit = result.optimal_unit;
+		sims_run = result.sims;
+		frames_run = result.frames;
+		async_profile = result.profile;
+		async_done = result.done;
+		simEachFlag = true;
+		return true;
+	}
 
-					if (valid_enemies)
-					{
-						addFriendlyType(type, army_size); //Add as many types as enemy score allows for even sim
+	bool Brawl::isAsyncDone() const
+	{
+		return async_done;
+	}
 
-						MCfap.simulate();
+	/// Convert every query on this thread, then run the races together
+	void Brawl::simulateBatch(const std::vector<EachQuery>& queries, std::vector<EachResult>& results)
+	{
+		resetFlags();
+		resetData();
 
-						setPostRank(scoring_type, army_size); // Set the types post FAP-sim score
-					}
-					MCfap.clear();
-				}
+		const int count = static_cast<int>(queries.size());
+		batch.resize(count);
+		for (int i = 0; i < count; ++i)
+		{
+			// Each query scales its own enemy composition
+			enemy_data.clear();
+			enemy_score = 0;
+
+			const EachQuery& query = queries[i];
+			convertEnemies(query.enemy_types, query.army_size);
+			makeRaceInput(batch.prepare(i), query.friendly_types, query.enemy_types, query.budget, query.scoring_type);
+		}
+		enemy_data.clear();
+		enemy_score = 0;
+
+		batch.run();
+
+		results.resize(count);
+		for (int i = 0; i < count; ++i)
+		{
+			const Race& r = batch.race(i);
+			results[i].ranks = r.ranks();
+			results[i].optimal_unit = r.optimalUnit();
+			results[i].sims = r.simCount();
+			results[i].frames = r.frameCount();
+
+			sims_run += r.simCount();
+			frames_run += r.frameCount();
+			profile += r.profile();
+		}
+	}
+
+	/// Search mixes of the friendly UnitTypes against the enemy units
+	void Brawl::searchComposition(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const ArmyBudget& budget, const CompositionOptions& options)
+	{
+		searchComposition(friendly_types, unitTypes(enemy_units, enemy_type_buffer), budget, options);
+	}
+
+	void Brawl::searchComposition(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const ArmyBudget& budget, const CompositionOptions& options)
+	{
+		resetFlags();
+		resetData();
+
+		prepareSearch(friendly_types, enemy_types, -1);
+		composition.run(budget, options, seed, engine, target_grid_units);
+		sims_run = composition.simCount();
+		frames_run = composition.frameCount();
+		profile.sims = sims_run;
+		profile.frames = frames_run;
+	}
+
+	/// Search the break-even army size of each friendly UnitType
+	void Brawl::findBreakEven(const BWAPI::UnitType::set& friendly_types, const BWAPI::Unitset& enemy_units, const BreakEvenOptions& options, int army_size)
+	{
+		findBreakEven(friendly_types, unitTypes(enemy_units, enemy_type_buffer), options, army_size);
+	}
+
+	void Brawl::findBreakEven(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const BreakEvenOptions& options, int army_size)
+	{
+		resetFlags();
+		resetData();
+
+		prepareSearch(friendly_types, enemy_types, army_size);
+		composition.breakEven(options, seed, engine, target_grid_units);
+		sims_run = composition.simCount();
+		frames_run = composition.frameCount();
+		profile.sims = sims_run;
+		profile.frames = frames_run;
+	}
+
+	const std::vector<BreakEven>& Brawl::getBreakEven() const
+	{
+		return composition.breakEvenResults();
+	}
+
+	/// Hand the enemy composition and the friendly UnitTypes that can attack it to the composition search
+	void Brawl::prepareSearch(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, int army_size)
+	{
+		convertEnemies(enemy_types, army_size);
+
+		ProfileScope scope(profile.conversion_us);
+		composition.clear();
+		for (const auto& group : enemy_data)
+		{
+			composition.addEnemies(prototypes.prototype(group.data->type, group.data->player), group.count);
+		}
+		for (const auto& type : friendly_types)
+		{
+			if (isValidType(type) && canAttackEnemies(type))
+			{
+				const UnitData& data = prototypes.data(type, game->self());
+				composition.addOption(prototypes.prototype(type, game->self()), friendlyArmySize(data)); // The even army is a good first guess
 			}
-			sortRanks();
-			setOptimalUnit();
 		}
-		simEachFlag = true;
+	}
+
+	const CompositionResult& Brawl::getComposition() const
+	{
+		return composition.result();
 	}
 
 	/// Simulate an entire friendly force against an entire enemy force
 	void Brawl::simulateForces(const BWAPI::Unitset& friendly_units, const BWAPI::Unitset& enemy_units, const int sims)
+	{
+		simulateForces(unitTypes(friendly_units, friendly_type_buffer), unitTypes(enemy_units, enemy_type_buffer), sims);
+	}
+
+	void Brawl::simulateForces(const std::vector<BWAPI::UnitType>& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const int sims)
 	{
 		resetFlags();
-		unit_ranks.reserve(friendly_units.size());
-		friendly_data.reserve(enemy_units.size());
+		resetData();
+		{
+			ProfileScope scope(profile.conversion_us);
+			prototypes.refresh(game->self());
+			prototypes.refresh(game->enemy());
+		}
 
 		// Invalid Simulation - one of the sides doesn't have any units to simulate against
-		if (friendly_units.empty() || enemy_units.empty())
+		if (friendly_types.empty() || enemy_types.empty())
 		{
 			return;
 		}
 		// Valid Simulation
 		else
 		{
-			// Setup friendly units
-			for (auto& unit : friendly_units)
+			const int trials = std::max(sims, 1);
+			if (result_cache.enabled() && !timeline_enabled)
 			{
-				if (isValidType(unit->getType()))
+				cache_key = forcesKey(friendly_types, enemy_types, trials);
+				if (const CachedResult* cached = result_cache.find(cache_key, game->frameCount()))
 				{
-					friendly_data.push_back(UnitData(unit->getType(), BWAPI::Broodwar->self()));
-					friendly_score += friendly_data.back().eco_score;
+					restoreResult(*cached);
+					simForcesFlag = true;
+					return;
+				}
+				cache_pending = true;
+			}
 
-					if (unit->getType().isTwoUnitsInOneEgg())
+			force_trials.configure(engine, target_grid_units);
+			force_trials.resize(trials);
+
+			enemy_order.clear();
+			{
+				ProfileScope scope(profile.conversion_us);
+
+				// Setup friendly units
+				for (const auto& type : friendly_types)
+				{
+					if (isValidType(type))
 					{
-						for (int i = 0; i < 2; i++)
-						{
-							MCfap.addUnitPlayer1(std::move(friendly_data.back().convertToFAPUnit()));
-						}
+						friendly_data.push_back(&prototypes.data(type, game->self()));
+						friendly_score += friendly_data.back()->eco_score;
 					}
-					else
+				}
+
+				// Setup enemy units
+				for (const auto& type : enemy_types)
+				{
+					if (isValidType(type))
 					{
-						MCfap.addUnitPlayer1(std::move(friendly_data.back().convertToFAPUnit()));
+						const UnitData& temp = prototypes.data(type, game->enemy());
+						enemy_data.add(temp);
+						enemy_score += temp.eco_score;
+						enemy_order.push_back(&temp);
 					}
 				}
 			}
-			// Take a copy of friendly pre simulation units
-			std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>> friendly_pre_units;
-			for (auto& u : *MCfap.getState().first)
-			{
-				auto temp = std::make_pair(u, 1);
-				friendly_pre_units.push_back(temp);
-			}
 
-			// Setup enemy units
-			for (auto& unit : enemy_units)
+			// Every trial adds its units in the same order, so a unit has the same id in every trial
+			for (int t = 0; t < trials; ++t)
 			{
-				if (isValidType(unit->getType()))
+				Rng rng(seed, t);
+				auto& sim = force_trials.sim(t);
+				sim.clear();
+				int id = 0;
 				{
-					UnitData temp = UnitData(unit->getType(), BWAPI::Broodwar->enemy());
-					enemy_data[temp]++;
-					enemy_score += temp.eco_score;
-
-					if (unit->getType().isTwoUnitsInOneEgg())
+					ProfileScope scope(profile.friendly_setup_us);
+					for (const auto data : friendly_data)
 					{
-						for (int i = 0; i < 2; i++)
+						for (int i = 0; i < (data->type.isTwoUnitsInOneEgg() ? 2 : 1); i++)
 						{
-							MCfap.addUnitPlayer2(std::move(temp.convertToFAPUnit()));
+							auto unit = prototypes.stamp(data->type, data->player, rng);
+							unit.data.id = id++;
+							sim.addUnitPlayer1(unit);
 						}
 					}
-					else
+				}
+				{
+					ProfileScope scope(profile.enemy_setup_us);
+					id = 0;
+					for (const auto data : enemy_order)
 					{
-						MCfap.addUnitPlayer2(std::move(temp.convertToFAPUnit()));
+						for (int i = 0; i < (data->type.isTwoUnitsInOneEgg() ? 2 : 1); i++)
+						{
+							auto unit = prototypes.stamp(data->type, data->player, rng);
+							unit.data.id = id++;
+							sim.addUnitPlayer2(unit);
+						}
 					}
 				}
 			}
-			// Take a copy of enemy pre simulation units
-			std::vector<std::pair<FAP::FAPUnit<UnitData*>, int>> enemy_pre_units;
-			for (auto& u : *MCfap.getState().second)
+
+			trackUnits(*force_trials.sim(0).getState().first, friendly_start);
+			trackUnits(*force_trials.sim(0).getState().second, enemy_start);
+			friendly_hp.resize(trials * friendly_start.size());
+			enemy_hp.resize(trials * enemy_start.size());
+
+			friendly_lost.assign(trials, 0);
+			enemy_lost.assign(trials, 0);
+			force_frames.assign(trials, 0);
+			if (timeline_enabled)
+			{
+				const int frames = timeline_options.frames > 0 ? timeline_options.frames : TrialSims::trial_frames;
+				const int capacity = timeline_options.capacity > 0 ? timeline_options.capacity : frames / std::max(timeline_options.interval, 1) + 2;
+				if (timelines.size() < static_cast<size_t>(trials))
+				{
+					timelines.resize(trials);
+				}
+				for (int t = 0; t < trials; ++t)
+				{
+					timelines[t].reset(capacity);
+				}
+				timeline_trials = trials;
+			}
+			{
+				ProfileScope scope(profile.simulate_us);
+				pool.parallelFor(trials, [&](int t)
+				{
+					force_frames[t] = timeline_enabled ? force_trials.simulate(t, timeline_options, timelines[t]) : force_trials.simulate(t);
+				});
+			}
 			{
-				auto temp = std::make_pair(u, 1);
-				enemy_pre_units.push_back(temp);
+				ProfileScope scope(profile.scoring_us);
+				pool.parallelFor(trials, [&](int t)
+				{
+					const auto state = force_trials.sim(t).getState();
+					friendly_lost[t] = tallySurvivors(*state.first, friendly_start, &friendly_hp[t * friendly_start.size()]);
+					enemy_lost[t] = tallySurvivors(*state.second, enemy_start, &enemy_hp[t * enemy_start.size()]);
+				});
+				setOutcomes(friendly_start, friendly_hp, trials, friendly_outcomes);
+				setOutcomes(enemy_start, enemy_hp, trials, enemy_outcomes);
 			}
 
-			MCfap.simulate();
+			friendly_score -= std::lround(std::accumulate(friendly_lost.begin(), friendly_lost.end(), 0.0) / trials);
+			enemy_score -= std::lround(std::accumulate(enemy_lost.begin(), enemy_lost.end(), 0.0) / trials);
+			frames_run = std::accumulate(force_frames.begin(), force_frames.end(), std::int64_t(0));
+			sims_run = trials;
 
-			checkAliveUnits(friendly_pre_units, enemy_pre_units);
+			profile.sims = sims_run;
+			profile.frames = frames_run;
 
-			MCfap.clear();
+			if (recorder && !timeline_enabled)
+			{
+				beginRecord(Scenario::Kind::Forces, enemy_types);
+				record.friendly_types = friendly_types;
+				record.trials = trials;
+				for (const auto data : friendly_data)
+				{
+					recordPrototype(prototypes.prototype(data->type, data->player), 0);
+				}
+				for (const auto data : enemy_order)
+				{
+					recordPrototype(prototypes.prototype(data->type, data->player), 1);
+				}
+				record.friendly_score = friendly_score;
+				record.enemy_score = enemy_score;
+				recorder->write(record);
+			}
+#ifdef BRAWLSIM_PROFILE
+			profile.units_killed += std::count(friendly_hp.begin(), friendly_hp.end(), 0) + std::count(enemy_hp.begin(), enemy_hp.end(), 0);
+			for (int t = 0; t < trials; ++t)
+			{
+				profile.early_exits += force_frames[t] < TrialSims::trial_frames;
+			}
+#endif
 		}
 		simForcesFlag = true;
+		cacheResult();
+	}
+
+	/// Key of a simulateEach() result. The enemy composition is taken scaled, so compositions that scale the same share a result
+	std::uint64_t Brawl::eachKey(const BWAPI::UnitType::set& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const SimBudget& budget, const int scoring_type, const int army_size) const
+	{
+		CacheKey key;
+		key.add(1);
+		key.addUnordered(friendly_types, [](const BWAPI::UnitType& type) { return type.getID(); });
+		key.add(enemy_types.empty());
+		for (const auto& group : enemy_data)
+		{
+			key.add(group.data->type.getID());
+			key.add(group.count);
+		}
+		key.add(static_cast<std::uint64_t>(budget.total_sims));
+		key.add(static_cast<std::uint64_t>(budget.microseconds));
+		key.add(static_cast<std::uint64_t>(budget.min_sims));
+		key.add(static_cast<std::uint64_t>(budget.max_sims));
+		key.add(static_cast<std::uint64_t>(std::llround(budget.z * 1000)));
+		key.add(static_cast<std::uint64_t>(std::llround(budget.prune_below * 1000)));
+		key.add(static_cast<std::uint64_t>(scoring_type));
+		key.add(static_cast<std::uint64_t>(army_size));
+		key.add(seed);
+		key.add(prototypes.fingerprint(game->self()));
+		key.add(prototypes.fingerprint(game->enemy()));
+		return key.value();
+	}
+
+	/// Start a record of the call with what every kind of call is run with
+	void Brawl::beginRecord(const Scenario::Kind kind, const std::vector<BWAPI::UnitType>& enemy_types)
+	{
+		record.clear();
+		record.kind = kind;
+		record.seed = seed;
+		record.frame = game->frameCount();
+		record.engine = engine;
+		record.enemy_types = enemy_types;
+
+		const BWAPI::Player players[2] = { game->self(), game->enemy() };
+		for (int side = 0; side < 2; ++side)
+		{
+			for (int id = 0; id < BWAPI::UpgradeTypes::Enum::MAX; ++id)
+			{
+				const int level = players[side]->getUpgradeLevel(BWAPI::UpgradeType(id));
+				if (level > 0)
+				{
+					record.players[side].upgrades.push_back(std::make_pair(id, level));
+				}
+			}
+			for (int id = 0; id < BWAPI::TechTypes::Enum::MAX; ++id)
+			{
+				if (players[side]->hasResearched(BWAPI::TechType(id)))
+				{
+					record.players[side].techs.push_back(id);
+				}
+			}
+		}
+	}
+
+	/// Add a prototype to the record unless the side already has its UnitType
+	void Brawl::recordPrototype(const FAP::FAPUnit<UnitTag>& prototype, const int side)
+	{
+		for (const auto& recorded : record.prototypes)
+		{
+			if (recorded.side == side && recorded.unit.unitType == prototype.unitType)
+			{
+				return;
+			}
+		}
+		ScenarioPrototype recorded;
+		recorded.side = side;
+		recorded.unit = prototype;
+		recorded.unit.data = UnitTag();
+		recorded.eco_score = prototype.data->eco_score;
+		recorded.survival_rate = prototype.data->survival_rate;
+		recorded.top_speed = prototype.data->top_speed;
+		record.prototypes.push_back(recorded);
+	}
+
+	void Brawl::setRecorder(ScenarioWriter* writer)
+	{
+		recorder = writer;
+	}
+
+	/// Key of what the trials of a race depend on besides the UnitTypes, so startUpdate() only carries over comparable trials
+	std::uint64_t Brawl::updateKey(const int scoring_type, const int army_size) const
+	{
+		CacheKey key;
+		key.add(static_cast<std::uint64_t>(scoring_type));
+		key.add(static_cast<std::uint64_t>(army_size));
+		key.add(seed);
+		key.add(prototypes.fingerprint(game->self()));
+		key.add(prototypes.fingerprint(game->enemy()));
+		return key.value();
+	}
+
+	/// Key of a simulateForces() result. Units are keyed in the order given: the outcomes are per unit in that order, and it decides each unit's position draws
+	std::uint64_t Brawl::forcesKey(const std::vector<BWAPI::UnitType>& friendly_types, const std::vector<BWAPI::UnitType>& enemy_types, const int trials) const
+	{
+		CacheKey key;
+		key.add(2);
+		for (const auto* types : { &friendly_types, &enemy_types })
+		{
+			key.add(types->size());
+			for (const auto& type : *types)
+			{
+				key.add(static_cast<std::uint64_t>(type.getID()));
+			}
+		}
+		key.add(static_cast<std::uint64_t>(trials));
+		key.add(seed);
+		key.add(prototypes.fingerprint(game->self()));
+		key.add(prototypes.fingerprint(game->enemy()));
+		return key.value();
+	}
+
+	/// Store the results of the finished sim call under its key if it missed the cache
+	void Brawl::cacheResult()
+	{
+		if (!cache_pending)
+		{
+			return;
+		}
+		cache_pending = false;
+
+		CachedResult& cached = result_cache.insert(cache_key, game->frameCount());
+		cached.unit_ranks = unit_ranks;
+		cached.optimal_unit = optimal_unit;
+		cached.friendly_score = friendly_score;
+		cached.enemy_score = enemy_score;
+		cached.friendly_outcomes = friendly_outcomes;
+		cached.enemy_outcomes = enemy_outcomes;
+	}
+
+	/// Show a cached result as the result of this call. No sims were run for it
+	void Brawl::restoreResult(const CachedResult& cached)
+	{
+		unit_ranks = cached.unit_ranks;
+		optimal_unit = cached.optimal_unit;
+		friendly_score = cached.friendly_score;
+		enemy_score = cached.enemy_score;
+		friendly_outcomes = cached.friendly_outcomes;
+		enemy_outcomes = cached.enemy_outcomes;
+	}
+
+	void Brawl::setResultCache(const int capacity, const int max_age_frames)
+	{
+		result_cache.configure(capacity, max_age_frames);
+	}
+
+	CacheStats Brawl::getCacheStats() const
+	{
+		return result_cache.stats();
+	}
+
+	void Brawl::setSeed(const std::uint64_t new_seed)
+	{
+		seed = new_seed;
+	}
+
+	void Brawl::setEngine(const SimEngine new_engine)
+	{
+		engine = new_engine;
+	}
+
+	void Brawl::setTargetGrid(const int min_units)
+	{
+		target_grid_units = min_units;
+	}
+
+	void Brawl::setSurvivalRates(const SurvivalRates& rates)
+	{
+		prototypes.setSurvivalRates(rates);
+		result_cache.clear(); // The scores of scoring type 0 start at the rates
+		update_ranks.clear();
 	}
 
 	/// Return top scored friendly unittype of the sim
@@ -398,12 +1078,32 @@ namespace BrawlSim
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of getOptimalUnit()");
+			game->sendText("Invalid use of getOptimalUnit()");
+			return BWAPI::UnitTypes::None;
 		}
 	}
 
 	/// Return BWAPI::UnitType and score of each unit in sim
 	std::vector<std::pair<BWAPI::UnitType, double>> Brawl::getUnitRanks() const
+	{
+		std::vector<std::pair<BWAPI::UnitType, double>> ranks;
+		if (simEachFlag)
+		{
+			ranks.reserve(unit_ranks.size());
+			for (const auto& u : unit_ranks)
+			{
+				ranks.push_back(std::make_pair(u.type, u.score));
+			}
+		}
+		else
+		{
+			game->sendText("Invalid use of getUnitRanks()");
+		}
+		return ranks;
+	}
+
+	/// Return BWAPI::UnitType, score, variance and trial count of each unit in sim
+	std::vector<UnitRank> Brawl::getUnitRankStats() const
 	{
 		if (simEachFlag)
 		{
@@ -411,10 +1111,30 @@ namespace BrawlSim
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of getUnitRanks()");
+			game->sendText("Invalid use of getUnitRankStats()");
+			return std::vector<UnitRank>();
 		}
 	}
 
+	int Brawl::getSimCount() const
+	{
+		return sims_run;
+	}
+
+	std::int64_t Brawl::getFrameCount() const
+	{
+		return frames_run;
+	}
+
+	/// The race's profile plus the conversion done before it started
+	SimProfile Brawl::getProfile() const
+	{
+		SimProfile result = profile;
+		result += race.profile();
+		result += async_profile;
+		return result;
+	}
+
 	/// Return the force with the highest score
 	std::pair<BWAPI::Player, int> Brawl::getBestForce() const
 	{
@@ -422,35 +1142,61 @@ namespace BrawlSim
 		{
 			if (friendly_score > enemy_score)
 			{
-				return std::make_pair(BWAPI::Broodwar->self(), friendly_score);
+				return std::make_pair(game->self(), friendly_score);
 			}
 			else if (friendly_score < enemy_score)
 			{
-				return std::make_pair(BWAPI::Broodwar->enemy(), enemy_score);
+				return std::make_pair(game->enemy(), enemy_score);
 			}
 			else
 			{
-				return std::make_pair(BWAPI::Broodwar->self(), NULL);
+				return std::make_pair(game->self(), 0);
 			}
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of getBestForces()");
-			return std::make_pair(BWAPI::Broodwar->self(), NULL);
+			game->sendText("Invalid use of getBestForces()");
+			return std::make_pair(game->self(), 0);
 		}
 	}
 
+	const std::vector<UnitOutcome>& Brawl::getFriendlyOutcomes() const
+	{
+		return friendly_outcomes;
+	}
+
+	const std::vector<UnitOutcome>& Brawl::getEnemyOutcomes() const
+	{
+		return enemy_outcomes;
+	}
+
+	void Brawl::setTimeline(const bool enabled, const TimelineOptions& options)
+	{
+		timeline_enabled = enabled;
+		timeline_options = options;
+	}
+
+	int Brawl::getTimelineCount() const
+	{
+		return timeline_trials;
+	}
+
+	const Timeline& Brawl::getTimeline(const int t) const
+	{
+		return timelines[t];
+	}
+
 	/// Draw the winning force and score in a unit vs unit simulation
 	void Brawl::drawBestForce(const int x, const int y) const
 	{
 		if (simForcesFlag)
 		{
-			BWAPI::Broodwar->drawTextScreen(x, y, "Force: %s", getBestForce().first);
-			BWAPI::Broodwar->drawTextScreen(x + 100, y, "Score: %s", getBestForce().second);
+			game->drawTextScreen(x, y, "Force: " + getBestForce().first->getName());
+			game->drawTextScreen(x + 100, y, "Score: " + std::to_string(getBestForce().second));
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of drawBestForce()");
+			game->sendText("Invalid use of drawBestForce()");
 		}
 	}
 
@@ -459,22 +1205,22 @@ namespace BrawlSim
 	{
 		if (simEachFlag)
 		{
-			BWAPI::Broodwar->drawTextScreen(x, y, "Brawl Unit: %s", getOptimalUnit().c_str());
+			game->drawTextScreen(x, y, "Brawl Unit: " + getOptimalUnit().getName());
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of drawOptimalUnit()");
+			game->sendText("Invalid use of drawOptimalUnit()");
 		}
 	}
 	void Brawl::drawOptimalUnit(const BWAPI::Position& pos) const
 	{
 		if (simEachFlag)
 		{
-			BWAPI::Broodwar->drawTextScreen(pos, "Brawl Unit: %s", getOptimalUnit().c_str());
+			game->drawTextScreen(pos.x, pos.y, "Brawl Unit: " + getOptimalUnit().getName());
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of drawOptimalUnit()");
+			game->sendText("Invalid use of drawOptimalUnit()");
 		}
 	}
 
@@ -486,14 +1232,14 @@ namespace BrawlSim
 			int spacing = 0;
 			for (const auto& u : getUnitRanks())
 			{
-				BWAPI::Broodwar->drawTextScreen(x, y + spacing, u.first.c_str());
-				BWAPI::Broodwar->drawTextScreen(x + 200, y + spacing, std::to_string(u.second).c_str());
+				game->drawTextScreen(x, y + spacing, u.first.getName());
+				game->drawTextScreen(x + 200, y + spacing, std::to_string(u.second));
 				spacing += 12;
 			}
 		}
 		else
 		{
-			BWAPI::Broodwar->sendText("Invalid use of drawUnitRank()");
+			game->sendText("Invalid use of drawUnitRank()");
 		}
 	}
 
@@ -503,6 +1249,36 @@ namespace BrawlSim
 		simForcesFlag = false;
 	}
 
+	/// Clear the results and unit data of the last simulation
+	void Brawl::resetData()
+	{
+		friendly_data.clear();
+		enemy_data.clear();
+		unit_ranks.clear();
+		friendly_outcomes.clear();
+		enemy_outcomes.clear();
+		cache_pending = false;
+		update_pending = false;
+		record_pending = false;
+		timeline_trials = 0;
+		sims_run = 0;
+		frames_run = 0;
+		profile = SimProfile();
+		async_profile = SimProfile();
+
+		// A new sim call replaces the results of whatever job was running, so the background race stops using its threads
+		race.reset();
+		if (async_race)
+		{
+			async_race->cancel();
+		}
+		async_done = true;
+
+		friendly_score = 0;
+		enemy_score = 0;
+		optimal_unit = BWAPI::UnitTypes::None;
+	}
+
 	/// @TODO Fix this to display each optimal unit being built simultaneously
 	///// Draw the most optimal unit for a specific building UnitType
 	//void drawOptimalUnit(const BWAPI::Unit& building)
@@ -0,0 +1,381 @@
+#include "../../BrawlSimLib/include/BrawlSim/CompositionSearch.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+namespace BrawlSim
+{
+	CompositionSearch::CompositionSearch(ThreadPool& thread_pool)
+		: pool(thread_pool)
+	{
+	}
+
+	void CompositionSearch::clear()
+	{
+		options.clear();
+		enemies.clear();
+		enemy_value = 0;
+	}
+
+	/// The price of a morphed or merged UnitType includes the units it is made from
+	void CompositionSearch::addOption(const FAP::FAPUnit<UnitTag>& prototype, const int guess)
+	{
+		const BWAPI::UnitType type = prototype.data->type;
+		Option option{ prototype, type.mineralPrice(), type.gasPrice(), type.supplyRequired() * (type.isTwoUnitsInOneEgg() ? 2 : 1), std::max(guess, 1) };
+
+		const MorphSource& source = morph_sources[type.getID()];
+		if (source.count)
+		{
+			const BWAPI::UnitType from(source.type);
+			option.minerals += from.mineralPrice() * source.count;
+			option.gas += from.gasPrice() * source.count;
+			option.supply += from.supplyRequired() * source.count;
+		}
+		options.push_back(option);
+	}
+
+	void CompositionSearch::addEnemies(const FAP::FAPUnit<UnitTag>& prototype, const int count)
+	{
+		enemies.push_back({ prototype, count });
+		enemy_value += static_cast<double>(prototype.data->eco_score) * count;
+	}
+
+	/// Grow the mixes of the beam a step at a time until the budget is spent, then trade steps of one UnitType for another while it helps
+	const CompositionResult& CompositionSearch::run(const ArmyBudget& budget, const CompositionOptions& search_options, const std::uint64_t seed, const SimEngine engine, const int grid_units)
+	{
+		limits = budget;
+		trials.configure(engine, grid_units);
+		search_result = CompositionResult();
+		sims_run = 0;
+		frames_run = 0;
+		candidates.clear();
+		beam.clear();
+		seen.clear();
+		if (options.empty() || enemies.empty())
+		{
+			return search_result;
+		}
+
+		const int trial_count = std::max(search_options.trials, 1);
+		buildEnemySnapshots(seed, trial_count);
+
+		const Mix empty(options.size(), 0);
+		for (int i = 0; i < static_cast<int>(options.size()); ++i)
+		{
+			const int affordable = room(empty, i);
+			options[i].chunk = affordable > 0 ? std::max(affordable / std::max(search_options.steps, 1), 1) : 0;
+		}
+
+		// No army leaves the enemy its whole eco score
+		Candidate best(empty);
+		best.stats.mean = -1;
+
+		beam.assign(1, empty);
+		seen.insert(empty);
+		while (!beam.empty())
+		{
+			candidates.clear();
+			for (const Mix& mix : beam)
+			{
+				for (int i = 0; i < static_cast<int>(options.size()); ++i)
+				{
+					const int n = std::min(options[i].chunk, room(mix, i));
+					if (n > 0)
+					{
+						Mix next = mix;
+						next[i] += n;
+						propose(next);
+					}
+				}
+			}
+			if (candidates.empty())
+			{
+				break;
+			}
+
+			evaluate(trial_count);
+			std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs)
+			{
+				return lhs.stats.mean > rhs.stats.mean;
+			});
+			if (candidates.front().stats.mean > best.stats.mean)
+			{
+				best = candidates.front();
+			}
+
+			beam.clear();
+			for (int k = 0; k < std::min(std::max(search_options.beam_width, 1), static_cast<int>(candidates.size())); ++k)
+			{
+				beam.push_back(candidates[k].mix);
+			}
+		}
+
+		for (int pass = 0; pass < search_options.swap_passes; ++pass)
+		{
+			candidates.clear();
+			for (int from = 0; from < static_cast<int>(options.size()); ++from)
+			{
+				for (int to = 0; best.mix[from] > 0 && to < static_cast<int>(options.size()); ++to)
+				{
+					if (to == from)
+					{
+						continue;
+					}
+					Mix next = best.mix;
+					next[from] -= std::min(options[from].chunk, next[from]);
+					const int n = std::min(options[to].chunk, room(next, to));
+					if (n > 0)
+					{
+						next[to] += n;
+						propose(next);
+					}
+				}
+			}
+			if (candidates.empty())
+			{
+				break;
+			}
+
+			evaluate(trial_count);
+			const auto top = std::max_element(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs)
+			{
+				return lhs.stats.mean < rhs.stats.mean;
+			});
+			if (top->stats.mean <= best.stats.mean)
+			{
+				break;
+			}
+			best = *top;
+		}
+
+		setResult(best);
+		return search_result;
+	}
+
+	const CompositionResult& CompositionSearch::result() const
+	{
+		return search_result;
+	}
+
+	/// Each round sims one army size per option still searching, all of them in one evaluate()
+	const std::vector<BreakEven>& CompositionSearch::breakEven(const BreakEvenOptions& search_options, const std::uint64_t seed, const SimEngine engine, const int grid_units)
+	{
+		trials.configure(engine, grid_units);
+		sims_run = 0;
+		frames_run = 0;
+		break_even.clear();
+		brackets.clear();
+		if (options.empty() || enemies.empty())
+		{
+			return break_even;
+		}
+
+		const int trial_count = std::max(search_options.trials, 1);
+		const int max_count = std::max(search_options.max_count, 1);
+		buildEnemySnapshots(seed, trial_count);
+
+		for (int i = 0; i < static_cast<int>(options.size()); ++i)
+		{
+			brackets.push_back({ i });
+			brackets.back().probe = std::min(options[i].guess, max_count);
+
+			BreakEven result;
+			result.type = options[i].prototype.data->type;
+			break_even.push_back(result);
+		}
+
+		while (!brackets.empty())
+		{
+			candidates.clear();
+			for (const auto& bracket : brackets)
+			{
+				candidates.emplace_back(Mix(options.size(), 0));
+				candidates.back().mix[bracket.option] = bracket.probe;
+			}
+			evaluate(trial_count);
+
+			size_t searching = 0;
+			for (size_t k = 0; k < brackets.size(); ++k)
+			{
+				Bracket& bracket = brackets[k];
+				const double rate = static_cast<double>(candidates[k].wins) / trial_count;
+				++break_even[bracket.option].probes;
+				if (rate > 0 && rate >= search_options.win_rate)
+				{
+					bracket.won = bracket.probe;
+					bracket.won_rate = rate;
+				}
+				else
+				{
+					bracket.lost = bracket.probe;
+					bracket.lost_rate = rate;
+				}
+
+				if (bracket.won < 0 && bracket.lost < max_count)
+				{
+					bracket.probe = std::min(bracket.lost * 2, max_count);
+				}
+				else if (bracket.won > bracket.lost + 1)
+				{
+					bracket.probe = (bracket.lost + bracket.won) / 2;
+				}
+				else
+				{
+					// Found, or max_count doesn't beat the enemy
+					BreakEven& result = break_even[bracket.option];
+					result.count = std::max(bracket.won, 0);
+					result.win_rate = bracket.won < 0 ? bracket.lost_rate : bracket.won_rate;
+					continue;
+				}
+				brackets[searching++] = bracket;
+			}
+			brackets.resize(searching);
+		}
+		return break_even;
+	}
+
+	const std::vector<BreakEven>& CompositionSearch::breakEvenResults() const
+	{
+		return break_even;
+	}
+
+	int CompositionSearch::simCount() const
+	{
+		return sims_run;
+	}
+
+	std::int64_t CompositionSearch::frameCount() const
+	{
+		return frames_run;
+	}
+
+	/// Enemy positions and the stream the friendly positions are drawn from are the same for every army simmed
+	void CompositionSearch::buildEnemySnapshots(const std::uint64_t seed, const int trial_count)
+	{
+		enemy_snapshots.resize(trial_count);
+		enemy_rngs.resize(trial_count);
+		for (int t = 0; t < trial_count; ++t)
+		{
+			Rng rng(seed, t);
+			enemy_snapshots[t].clear();
+			for (const auto& group : enemies)
+			{
+				for (int i = 0; i < group.count; ++i)
+				{
+					enemy_snapshots[t].push_back(group.prototype.data->stampFAPUnit(group.prototype, rng));
+				}
+			}
+			enemy_rngs[t] = rng;
+		}
+	}
+
+	/// How many more of option i the mix can afford
+	int CompositionSearch::room(const Mix& mix, const int i) const
+	{
+		int minerals = limits.minerals;
+		int gas = limits.gas;
+		int supply = limits.supply;
+		for (int k = 0; k < static_cast<int>(options.size()); ++k)
+		{
+			minerals -= mix[k] * options[k].minerals;
+			gas -= mix[k] * options[k].gas;
+			supply -= mix[k] * options[k].supply;
+		}
+
+		int n = INT_MAX;
+		const Option& option = options[i];
+		if (option.minerals > 0)
+		{
+			n = std::min(n, minerals / option.minerals);
+		}
+		if (option.gas > 0)
+		{
+			n = std::min(n, gas / option.gas);
+		}
+		if (option.supply > 0)
+		{
+			n = std::min(n, supply / option.supply);
+		}
+		return std::max(n, 0);
+	}
+
+	/// Add a mix to the candidates unless it was simmed before
+	void CompositionSearch::propose(const Mix& mix)
+	{
+		if (seen.insert(mix).second)
+		{
+			candidates.emplace_back(mix);
+		}
+	}
+
+	/// Sim every candidate in its trials, all of them in one parallelFor
+	void CompositionSearch::evaluate(const int trial_count)
+	{
+		const int count = static_cast<int>(candidates.size()) * trial_count;
+		trials.resize(count);
+		trial_scores.resize(count);
+		trial_frames.resize(count);
+
+		pool.parallelFor(count, [&](int j)
+		{
+			const Mix& mix = candidates[j / trial_count].mix;
+			const int t = j % trial_count;
+			auto& sim = trials.sim(j);
+			Rng rng = enemy_rngs[t];
+			sim.clear();
+			sim.setUnitsPlayer2(enemy_snapshots[t]);
+			for (int i = 0; i < static_cast<int>(options.size()); ++i)
+			{
+				const FAP::FAPUnit<UnitTag>& prototype = options[i].prototype;
+				const int units = mix[i] * (prototype.data->type.isTwoUnitsInOneEgg() ? 2 : 1); //zerglings and scourges
+				for (int n = 0; n < units; ++n)
+				{
+					sim.addUnitPlayer1(prototype.data->stampFAPUnit(prototype, rng));
+				}
+			}
+			trial_frames[j] = trials.simulate(j);
+			trial_scores[j] = trialScore(sim);
+		});
+
+		for (int j = 0; j < count; ++j)
+		{
+			candidates[j / trial_count].stats.add(trial_scores[j]);
+			candidates[j / trial_count].wins += trial_scores[j] > 0;
+			frames_run += trial_frames[j];
+		}
+		search_result.candidates += static_cast<int>(candidates.size());
+		sims_run += count;
+	}
+
+	/// Eco score left of the friendly army minus that left of the enemy, over the enemy's starting eco score
+	double CompositionSearch::trialScore(FAP::FastAPproximation<UnitTag>& sim) const
+	{
+		const auto left = [](const std::vector<FAP::FAPUnit<UnitTag>>& units)
+		{
+			double value = 0;
+			for (const auto& fu : units)
+			{
+				value += (fu.health + fu.shields) / (double)(fu.maxHealth + fu.maxShields) * fu.data->eco_score;
+			}
+			return value;
+		};
+		const auto state = sim.getState();
+		return (left(*state.first) - left(*state.second)) / std::max(enemy_value, 1.0);
+	}
+
+	void CompositionSearch::setResult(const Candidate& best)
+	{
+		for (int i = 0; i < static_cast<int>(options.size()); ++i)
+		{
+			if (best.mix[i] > 0)
+			{
+				search_result.units.push_back(std::make_pair(options[i].prototype.data->type, best.mix[i]));
+				search_result.minerals += best.mix[i] * options[i].minerals;
+				search_result.gas += best.mix[i] * options[i].gas;
+				search_result.supply += best.mix[i] * options[i].supply;
+			}
+		}
+		search_result.score = best.stats.mean;
+		search_result.variance = best.stats.variance();
+		search_result.sims = sims_run;
+		search_result.frames = frames_run;
+	}
+}
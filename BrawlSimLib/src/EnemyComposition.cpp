@@ -0,0 +1,81 @@
+#include "../../BrawlSimLib/include/BrawlSim/EnemyComposition.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+#include <cmath>
+
+namespace BrawlSim
+{
+	EnemyComposition::EnemyComposition()
+	{
+		slots.fill(-1);
+	}
+
+	void EnemyComposition::add(const UnitData& data)
+	{
+		++unit_total;
+		int& slot = slots[data.type.getID()];
+		if (slot >= 0)
+		{
+			++groups[slot].count;
+			return;
+		}
+
+		// First unit of the type. Insert in ID order and move the slots of the groups after it
+		int index = static_cast<int>(groups.size());
+		while (index > 0 && groups[index - 1].data->type.getID() > data.type.getID())
+		{
+			--index;
+		}
+		groups.insert(groups.begin() + index, { &data, 1 });
+		for (int i = index; i < static_cast<int>(groups.size()); ++i)
+		{
+			slots[groups[i].data->type.getID()] = i;
+		}
+		air_types += data.type.isFlyer();
+	}
+
+	void EnemyComposition::scale(const int army_size)
+	{
+		for (auto& group : groups)
+		{
+			double percent = group.count / (double)unit_total;
+			group.count = std::lround(percent * army_size);
+		}
+	}
+
+	void EnemyComposition::clear()
+	{
+		for (const auto& group : groups)
+		{
+			slots[group.data->type.getID()] = -1;
+		}
+		groups.clear();
+		unit_total = 0;
+		air_types = 0;
+	}
+
+	bool EnemyComposition::hasAir() const
+	{
+		return air_types > 0;
+	}
+
+	bool EnemyComposition::hasGround() const
+	{
+		return air_types < static_cast<int>(groups.size());
+	}
+
+	int EnemyComposition::unitTotal() const
+	{
+		return unit_total;
+	}
+
+	std::vector<EnemyComposition::Group>::const_iterator EnemyComposition::begin() const
+	{
+		return groups.begin();
+	}
+
+	std::vector<EnemyComposition::Group>::const_iterator EnemyComposition::end() const
+	{
+		return groups.end();
+	}
+}
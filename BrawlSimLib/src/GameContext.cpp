@@ -0,0 +1,35 @@
+#include "../../BrawlSimLib/include/BrawlSim/GameContext.hpp"
+
+namespace BrawlSim
+{
+	BWAPI::Player LiveGame::self() const
+	{
+		return BWAPI::Broodwar->self();
+	}
+
+	BWAPI::Player LiveGame::enemy() const
+	{
+		return BWAPI::Broodwar->enemy();
+	}
+
+	int LiveGame::frameCount() const
+	{
+		return BWAPI::Broodwar->getFrameCount();
+	}
+
+	void LiveGame::sendText(const std::string& text)
+	{
+		BWAPI::Broodwar->sendText("%s", text.c_str());
+	}
+
+	void LiveGame::drawTextScreen(const int x, const int y, const std::string& text)
+	{
+		BWAPI::Broodwar->drawTextScreen(x, y, "%s", text.c_str());
+	}
+
+	GameContext& liveGame()
+	{
+		static LiveGame game;
+		return game;
+	}
+}
@@ -0,0 +1,122 @@
+#include "../../BrawlSimLib/include/BrawlSim/Lanchester.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+namespace BrawlSim
+{
+	namespace
+	{
+		/// Units of target the attacker kills per frame once in range, the way FAP deals damage. 0 if it can't hit the target
+		double killRate(const FAP::FAPUnit<UnitTag>& attacker, const FAP::FAPUnit<UnitTag>& target, const double distance, const int frames)
+		{
+			const int damage = target.flying ? attacker.airDamage : attacker.groundDamage;
+			const int cooldown = target.flying ? attacker.airCooldown : attacker.groundCooldown;
+			const BWAPI::DamageType type = target.flying ? attacker.airDamageType : attacker.groundDamageType;
+			const double max_range = std::sqrt(static_cast<double>(target.flying ? attacker.airMaxRangeSquared : attacker.groundMaxRangeSquared));
+			const double min_range = std::sqrt(static_cast<double>(target.flying ? attacker.airMinRangeSquared : attacker.groundMinRangeSquared));
+			if (damage <= 0 || min_range > distance)
+			{
+				return 0;
+			}
+
+			// Shields take the damage less shield armor, hit points take it less armor and scaled to the target's size, at least half a point
+			double health_damage = damage - target.armor;
+			if (type == BWAPI::DamageTypes::Concussive)
+			{
+				health_damage *= target.unitSize == BWAPI::UnitSizeTypes::Large ? 0.25 : target.unitSize == BWAPI::UnitSizeTypes::Medium ? 0.5 : 1;
+			}
+			else if (type == BWAPI::DamageTypes::Explosive)
+			{
+				health_damage *= target.unitSize == BWAPI::UnitSizeTypes::Small ? 0.5 : target.unitSize == BWAPI::UnitSizeTypes::Medium ? 0.75 : 1;
+			}
+			const double hits =
+				(target.shields >> 8) / std::max(static_cast<double>(damage - target.shieldArmor), 0.5) +
+				(target.health >> 8) / std::max(health_damage, 0.5);
+
+			// Frames spent closing in to range count against the trial
+			const double delay = distance > max_range ? (distance - max_range) / std::max(static_cast<double>(attacker.speed), 0.01) : 0;
+			const double share = std::max(frames - delay, 0.0) / frames;
+			return share / (std::max(hits, 1.0) * std::max(cooldown, 1));
+		}
+	}
+
+	/// Lanchester square law over a trial of the contender's army x against the enemies it can hit y, plus a constant loss c to the enemies it can't:
+	///     x' = -a y - c, y' = -b x
+	/// Shifting y by c / a leaves the square law, which is solved in closed form until either side is out or the trial ends.
+	double lanchesterScore(const RaceInput::Contender& contender, const std::vector<RaceInput::EnemyGroup>& enemies)
+	{
+		const FAP::FAPUnit<UnitTag>& friendly = contender.prototype;
+		const int frames = TrialSims::trial_frames;
+		const double x0 = contender.army_size * (friendly.data->type.isTwoUnitsInOneEgg() ? 2 : 1);
+		if (x0 <= 0)
+		{
+			return 0;
+		}
+
+		double y0 = 0;
+		double a = 0;
+		double c = 0;
+		double kill_frames = 0;
+		for (const auto& group : enemies)
+		{
+			const FAP::FAPUnit<UnitTag>& enemy = group.prototype;
+
+			// About the mean distance between two units spread the way UnitData::positionMCFAP() places them
+			const double distance = 0.52 * 4 * (static_cast<int>(friendly.data->top_speed) + static_cast<int>(enemy.data->top_speed));
+
+			const double dealt = killRate(friendly, enemy, distance, frames);
+			const double taken = killRate(enemy, friendly, distance, frames);
+			if (dealt > 0)
+			{
+				y0 += group.count;
+				a += group.count * taken;
+				kill_frames += group.count / dealt;
+			}
+			else
+			{
+				c += group.count * taken;
+			}
+		}
+		if (y0 > 0)
+		{
+			a /= y0;
+		}
+		const double b = kill_frames > 0 ? y0 / kill_frames : 0;
+
+		double x = x0;
+		if (a <= 0 || b <= 0)
+		{
+			// Only one side of the square law fights, the other loses units at a constant rate
+			x = x0 - (a * y0 + c) * frames;
+		}
+		else
+		{
+			const double k = std::sqrt(a * b);
+			const double shift = c / a;
+			const double ratio = std::sqrt(a / b);
+			const auto friendly_left = [&](const double t) { return x0 * std::cosh(k * t) - (y0 + shift) * ratio * std::sinh(k * t); };
+			const auto enemy_left = [&](const double t) { return (y0 + shift) * std::cosh(k * t) - x0 / ratio * std::sinh(k * t) - shift; };
+
+			// The army is out at tanh(k t) = x0 / ((y0 + c / a) * sqrt(a / b))
+			const double out = x0 / ((y0 + shift) * ratio);
+			const double end = out < 1 ? std::min(std::atanh(out) / k, static_cast<double>(frames)) : frames;
+
+			if (enemy_left(end) > 0)
+			{
+				x = friendly_left(end);
+			}
+			else
+			{
+				// The enemies it can hit are out first. enemy_left falls while the army is in, so find when by bisection
+				double lo = 0;
+				double hi = end;
+				for (int i = 0; i < 32; ++i)
+				{
+					const double mid = (lo + hi) / 2;
+					(enemy_left(mid) > 0 ? lo : hi) = mid;
+				}
+				x = friendly_left(hi) - c * (frames - hi);
+			}
+		}
+		return std::min(std::max(x / x0, 0.0), 1.0) * contender.initial_score;
+	}
+}
@@ -0,0 +1,118 @@
+#include "../../BrawlSimLib/include/BrawlSim/OfflineGame.hpp"
+
+namespace BrawlSim
+{
+	OfflinePlayer::OfflinePlayer(const int player_id, const BWAPI::Race& player_race, const std::string& player_name)
+		: id(player_id)
+		, race(player_race)
+		, name(player_name)
+	{
+	}
+
+	void OfflinePlayer::setUpgradeLevel(const BWAPI::UpgradeType& upgrade, const int level)
+	{
+		upgrade_levels[upgrade.getID()] = level;
+	}
+
+	void OfflinePlayer::setResearched(const BWAPI::TechType& tech, const bool is_researched)
+	{
+		researched[tech.getID()] = is_researched;
+	}
+
+	int OfflinePlayer::getID() const { return id; }
+	std::string OfflinePlayer::getName() const { return name; }
+	const BWAPI::Unitset& OfflinePlayer::getUnits() const { return units; }
+	BWAPI::Race OfflinePlayer::getRace() const { return race; }
+	BWAPI::PlayerType OfflinePlayer::getType() const { return BWAPI::PlayerTypes::Computer; }
+	BWAPI::Force OfflinePlayer::getForce() const { return nullptr; }
+	bool OfflinePlayer::isAlly(const BWAPI::Player player) const { return player == this; }
+	bool OfflinePlayer::isEnemy(const BWAPI::Player player) const { return player && player != this; }
+	bool OfflinePlayer::isNeutral() const { return false; }
+	BWAPI::TilePosition OfflinePlayer::getStartLocation() const { return BWAPI::TilePositions::None; }
+	bool OfflinePlayer::isVictorious() const { return false; }
+	bool OfflinePlayer::isDefeated() const { return false; }
+	bool OfflinePlayer::leftGame() const { return false; }
+	int OfflinePlayer::minerals() const { return 0; }
+	int OfflinePlayer::gas() const { return 0; }
+	int OfflinePlayer::gatheredMinerals() const { return 0; }
+	int OfflinePlayer::gatheredGas() const { return 0; }
+	int OfflinePlayer::repairedMinerals() const { return 0; }
+	int OfflinePlayer::repairedGas() const { return 0; }
+	int OfflinePlayer::refundedMinerals() const { return 0; }
+	int OfflinePlayer::refundedGas() const { return 0; }
+	int OfflinePlayer::spentMinerals() const { return 0; }
+	int OfflinePlayer::spentGas() const { return 0; }
+	int OfflinePlayer::supplyTotal(BWAPI::Race) const { return 0; }
+	int OfflinePlayer::supplyUsed(BWAPI::Race) const { return 0; }
+	int OfflinePlayer::allUnitCount(BWAPI::UnitType) const { return 0; }
+	int OfflinePlayer::visibleUnitCount(BWAPI::UnitType) const { return 0; }
+	int OfflinePlayer::completedUnitCount(BWAPI::UnitType) const { return 0; }
+	int OfflinePlayer::deadUnitCount(BWAPI::UnitType) const { return 0; }
+	int OfflinePlayer::killedUnitCount(BWAPI::UnitType) const { return 0; }
+
+	int OfflinePlayer::getUpgradeLevel(BWAPI::UpgradeType upgrade) const
+	{
+		return upgrade.getID() >= 0 && upgrade.getID() < BWAPI::UpgradeTypes::Enum::MAX ? upgrade_levels[upgrade.getID()] : 0;
+	}
+
+	bool OfflinePlayer::hasResearched(BWAPI::TechType tech) const
+	{
+		return tech.getID() >= 0 && tech.getID() < BWAPI::TechTypes::Enum::MAX && researched[tech.getID()];
+	}
+
+	bool OfflinePlayer::isResearching(BWAPI::TechType) const { return false; }
+	bool OfflinePlayer::isUpgrading(BWAPI::UpgradeType) const { return false; }
+	BWAPI::Color OfflinePlayer::getColor() const { return BWAPI::Colors::White; }
+	int OfflinePlayer::getUnitScore() const { return 0; }
+	int OfflinePlayer::getKillScore() const { return 0; }
+	int OfflinePlayer::getBuildingScore() const { return 0; }
+	int OfflinePlayer::getRazingScore() const { return 0; }
+	int OfflinePlayer::getCustomScore() const { return 0; }
+	bool OfflinePlayer::isObserver() const { return false; }
+	int OfflinePlayer::getMaxUpgradeLevel(BWAPI::UpgradeType upgrade) const { return upgrade.maxRepeats(); }
+	bool OfflinePlayer::isResearchAvailable(BWAPI::TechType) const { return true; }
+	bool OfflinePlayer::isUnitAvailable(BWAPI::UnitType) const { return true; }
+
+	OfflineGame::OfflineGame(const BWAPI::Race& self_race, const BWAPI::Race& enemy_race, std::ostream* text_log)
+		: self_player(0, self_race, "Self")
+		, enemy_player(1, enemy_race, "Enemy")
+		, log(text_log)
+	{
+	}
+
+	OfflinePlayer* OfflineGame::self() const
+	{
+		return &self_player;
+	}
+
+	OfflinePlayer* OfflineGame::enemy() const
+	{
+		return &enemy_player;
+	}
+
+	int OfflineGame::frameCount() const
+	{
+		return frame;
+	}
+
+	void OfflineGame::setFrameCount(const int new_frame)
+	{
+		frame = new_frame;
+	}
+
+	void OfflineGame::sendText(const std::string& text)
+	{
+		if (log)
+		{
+			*log << text << '\n';
+		}
+	}
+
+	void OfflineGame::drawTextScreen(const int x, const int y, const std::string& text)
+	{
+		if (log)
+		{
+			*log << '(' << x << ", " << y << ") " << text << '\n';
+		}
+	}
+}
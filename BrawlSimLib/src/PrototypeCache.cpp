@@ -0,0 +1,133 @@
+#include "../../BrawlSimLib/include/BrawlSim/PrototypeCache.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+namespace BrawlSim
+{
+	namespace
+	{
+		/// Entries are keyed by player id in the high word and UnitType id in the low word
+		std::uint64_t entryKey(const BWAPI::UnitType& type, const BWAPI::Player& player)
+		{
+			return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(player->getID())) << 32) | static_cast<std::uint32_t>(type.getID());
+		}
+
+		/// FNV-1a
+		void hashCombine(std::uint64_t& hash, const int value)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				hash ^= (static_cast<std::uint32_t>(value) >> (8 * i)) & 0xFF;
+				hash *= 0x100000001B3ull;
+			}
+		}
+	}
+
+	std::uint64_t upgradeFingerprint(const BWAPI::Player& player)
+	{
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		for (const auto& upgrade : BWAPI::UpgradeTypes::allUpgradeTypes())
+		{
+			int level = player->getUpgradeLevel(upgrade);
+			if (level)
+			{
+				hashCombine(hash, upgrade.getID());
+				hashCombine(hash, level);
+			}
+		}
+		for (const auto& tech : BWAPI::TechTypes::allTechTypes())
+		{
+			if (player->hasResearched(tech))
+			{
+				hashCombine(hash, tech.getID());
+			}
+		}
+		return hash;
+	}
+
+	struct PrototypeCache::Entry
+	{
+		UnitData						data;
+		FAP::FAPUnit<UnitTag>			unit;
+
+		// prototypeFAPUnit() points the unit at data, so Entries are never copied or moved
+		Entry(const BWAPI::UnitType& type, const BWAPI::Player& player, const SurvivalRates& survival_rates)
+			: data(type, player, survival_rates)
+			, unit(data.prototypeFAPUnit())
+		{
+		}
+		Entry(const Entry&) = delete;
+		Entry& operator=(const Entry&) = delete;
+	};
+
+	PrototypeCache::PrototypeCache() = default;
+	PrototypeCache::~PrototypeCache() = default;
+
+	void PrototypeCache::refresh(const BWAPI::Player& player)
+	{
+		const std::uint64_t fingerprint = upgradeFingerprint(player);
+
+		auto it = fingerprints.find(player->getID());
+		if (it != fingerprints.end() && it->second == fingerprint)
+		{
+			return;
+		}
+		fingerprints[player->getID()] = fingerprint;
+
+		// An upgrade or tech completed, drop the player's prototypes
+		for (auto e = entries.begin(); e != entries.end();)
+		{
+			if (e->second->data.player == player)
+			{
+				e = entries.erase(e);
+			}
+			else
+			{
+				++e;
+			}
+		}
+	}
+
+	PrototypeCache::Entry& PrototypeCache::entry(const BWAPI::UnitType& type, const BWAPI::Player& player)
+	{
+		auto& e = entries[entryKey(type, player)];
+		if (!e)
+		{
+			e = std::make_unique<Entry>(type, player, survival_rates);
+		}
+		return *e;
+	}
+
+	const UnitData& PrototypeCache::data(const BWAPI::UnitType& type, const BWAPI::Player& player)
+	{
+		return entry(type, player).data;
+	}
+
+	const FAP::FAPUnit<UnitTag>& PrototypeCache::prototype(const BWAPI::UnitType& type, const BWAPI::Player& player)
+	{
+		return entry(type, player).unit;
+	}
+
+	FAP::FAPUnit<UnitTag> PrototypeCache::stamp(const BWAPI::UnitType& type, const BWAPI::Player& player, Rng& rng)
+	{
+		const Entry& e = entry(type, player);
+		return e.data.stampFAPUnit(e.unit, rng);
+	}
+
+	std::uint64_t PrototypeCache::fingerprint(const BWAPI::Player& player) const
+	{
+		const auto it = fingerprints.find(player->getID());
+		return it != fingerprints.end() ? it->second : 0;
+	}
+
+	void PrototypeCache::clear()
+	{
+		entries.clear();
+		fingerprints.clear();
+	}
+
+	void PrototypeCache::setSurvivalRates(const SurvivalRates& rates)
+	{
+		survival_rates = rates;
+		clear();
+	}
+}
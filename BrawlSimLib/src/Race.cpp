@@ -0,0 +1,483 @@
+#include "../../BrawlSimLib/include/BrawlSim/Race.hpp"
+#include "../../BrawlSimLib/include/BrawlSim/UnitData.hpp"
+
+namespace BrawlSim
+{
+	FAP::FAPUnit<UnitTag> RaceInput::own(const UnitData& data, const FAP::FAPUnit<UnitTag>& prototype)
+	{
+		if (owned < unit_data.size())
+		{
+			*unit_data[owned] = data;
+		}
+		else
+		{
+			unit_data.push_back(std::make_shared<UnitData>(data));
+		}
+		FAP::FAPUnit<UnitTag> unit(prototype);
+		unit.data = unit_data[owned++].get();
+		return unit;
+	}
+
+	void RaceInput::clear()
+	{
+		contenders.clear();
+		enemies.clear();
+		unraced_ranks.clear();
+		pruned_ranks.clear();
+		budget = SimBudget();
+		seed = 0;
+		engine = SimEngine::ArrayOfStructs;
+		target_grid_units = 100;
+		owned = 0;
+	}
+
+	Race::Race(ThreadPool& thread_pool)
+		: pool(thread_pool)
+	{
+	}
+
+	void Race::start(RaceInput&& new_input)
+	{
+		input = std::move(new_input);
+		start();
+	}
+
+	RaceInput& Race::prepare()
+	{
+		reset();
+		return input;
+	}
+
+	void Race::start()
+	{
+		input.budget.min_sims = std::max(input.budget.min_sims, 1);
+		input.budget.max_sims = std::max(input.budget.max_sims, input.budget.min_sims);
+		trials.configure(input.engine, input.target_grid_units);
+
+		runners.clear();
+		bool carried = false;
+		for (const auto& contender : input.contenders)
+		{
+			runners.push_back({ &contender, contender.prior });
+			carried = carried || contender.prior.count > 0;
+		}
+
+		snapshot_count = 0;
+		sims_run = 0;
+		frames_run = 0;
+		race_profile = SimProfile();
+		open_runners = static_cast<int>(runners.size());
+		race_time = 0;
+		round_running = false;
+		done = runners.empty();
+		if (carried)
+		{
+			// Contenders already out of the race on their carried trials don't get new ones
+			dropTrailing();
+		}
+		publishRanks();
+	}
+
+	/// Run the race until it is done or the step budget is used up
+	bool Race::step(const StepBudget& step_budget)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		auto mark = start;
+		int frames = step_budget.frames > 0 ? step_budget.frames : INT_MAX;
+
+		while (!done && frames > 0)
+		{
+			if (!round_running && !startRound())
+			{
+				done = true;
+				break;
+			}
+
+			// Short chunks when the time is limited so it isn't overrun by much
+			const int chunk = std::min(frames, step_budget.microseconds > 0 ? 8 : TrialSims::trial_frames);
+			const bool round_over = advanceRound(chunk);
+			if (frames != INT_MAX)
+			{
+				frames -= chunk;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			race_time += std::chrono::duration_cast<std::chrono::microseconds>(now - mark).count();
+			mark = now;
+
+			if (round_over)
+			{
+				finishRound();
+			}
+			if (step_budget.microseconds > 0 && std::chrono::duration_cast<std::chrono::microseconds>(now - start).count() >= step_budget.microseconds)
+			{
+				break;
+			}
+		}
+		return done;
+	}
+
+	void Race::reset()
+	{
+		input.clear();
+		runners.clear();
+		unit_ranks.clear();
+		optimal_unit = BWAPI::UnitTypes::None;
+		snapshot_count = 0;
+		sims_run = 0;
+		frames_run = 0;
+		race_profile = SimProfile();
+		round_running = false;
+		done = true;
+	}
+
+	int Race::beginRound()
+	{
+		if (!done && !round_running && !startRound())
+		{
+			done = true;
+		}
+		return done ? 0 : static_cast<int>(round_jobs.size());
+	}
+
+	void Race::runTrial(const int j)
+	{
+		advanceTrial(j, TrialSims::trial_frames);
+	}
+
+	void Race::endRound(const std::int64_t microseconds)
+	{
+		race_time += microseconds;
+#ifdef BRAWLSIM_PROFILE
+		race_profile.simulate_us += microseconds;
+#endif
+		finishRound();
+	}
+
+	bool Race::isDone() const
+	{
+		return done;
+	}
+
+	const std::vector<UnitRank>& Race::ranks() const
+	{
+		return unit_ranks;
+	}
+
+	BWAPI::UnitType Race::optimalUnit() const
+	{
+		return optimal_unit;
+	}
+
+	int Race::simCount() const
+	{
+		return sims_run;
+	}
+
+	std::int64_t Race::frameCount() const
+	{
+		return frames_run;
+	}
+
+	const SimProfile& Race::profile() const
+	{
+		return race_profile;
+	}
+
+	/// Add the scaled enemy unit composition to a trial's units
+	void Race::addEnemyTypes(std::vector<FAP::FAPUnit<UnitTag>>& units, Rng& rng) const
+	{
+		for (const auto& group : input.enemies)
+		{
+			for (int i = 0; i < group.count; ++i)
+			{
+				units.push_back(group.prototype.data->stampFAPUnit(group.prototype, rng));
+			}
+		}
+	}
+
+	/// Build each trial's enemy army once. Every contender's sim starts from a copy of it
+	void Race::buildEnemySnapshots(const int count)
+	{
+		if (enemy_snapshots.size() < static_cast<size_t>(count))
+		{
+			enemy_snapshots.resize(count);
+			enemy_rngs.resize(count);
+		}
+		for (int t = snapshot_count; t < count; ++t)
+		{
+			Rng rng(input.seed, t);
+			enemy_snapshots[t].clear();
+			addEnemyTypes(enemy_snapshots[t], rng);
+			enemy_rngs[t] = rng; // Friendly positions continue the trial's stream
+		}
+		snapshot_count = std::max(snapshot_count, count);
+	}
+
+	/// Add a contender's army to a trial sim
+	void Race::addContender(FAP::FastAPproximation<UnitTag>& sim, const RaceInput::Contender& contender, Rng& rng) const
+	{
+		const UnitData& data = *contender.prototype.data;
+		for (int n = 0; n < contender.army_size; ++n)
+		{
+			if (data.type.isTwoUnitsInOneEgg()) //zerglings and scourges
+			{
+				for (int i = 0; i < 2; i++)
+				{
+					sim.addUnitPlayer1(data.stampFAPUnit(contender.prototype, rng));
+				}
+			}
+			else
+			{
+				sim.addUnitPlayer1(data.stampFAPUnit(contender.prototype, rng));
+			}
+		}
+	}
+
+	/// Score of the friendly units remaining in a trial sim
+	double Race::postScore(FAP::FastAPproximation<UnitTag>& sim, const double initial_score, const int army_size) const
+	{
+		double res_score = 0;
+		int i = 0;
+		// Accumulate total score for the unittype and increment the count;
+		for (auto& fu : *sim.getState().first)
+		{
+			double proportion_health = (fu.health + fu.shields) / (double)(fu.maxHealth + fu.maxShields);
+
+			res_score = (i * res_score + (proportion_health * initial_score)) / (double)(i + 1);
+			++i;
+		}
+		for (; i < army_size; ++i) //size discrepancy, these units died in sim
+		{
+			res_score = (i * res_score) / (double)(i + 1);
+		}
+		return res_score;
+	}
+
+	/// Set up the next round of trials. Every runner starts with min_sims trials, then the threads are shared between the runners still racing
+	bool Race::startRound()
+	{
+		const SimBudget& budget = input.budget;
+		round_jobs.clear();
+		const int round = sims_run == 0 ? budget.min_sims : std::max(1, static_cast<int>(pool.size()) / std::max(open_runners, 1));
+		for (int r = 0; r < static_cast<int>(runners.size()); ++r)
+		{
+			// The first round brings every runner up to min_sims, with at least one new trial for carried runners
+			const int finished = runners[r].stats.count;
+			const int trials_due = sims_run == 0 ? std::max(round - finished, 1) : round;
+			for (int t = finished; runners[r].racing && t < std::min(finished + trials_due, budget.max_sims); ++t)
+			{
+				round_jobs.push_back(std::make_pair(r, t));
+			}
+		}
+		if (budget.total_sims > 0 && sims_run + static_cast<int>(round_jobs.size()) > budget.total_sims)
+		{
+			round_jobs.resize(std::max(budget.total_sims - sims_run, 0));
+		}
+		if (round_jobs.empty())
+		{
+			return false;
+		}
+
+		const int count = static_cast<int>(round_jobs.size());
+		trials.resize(count);
+		trial_scores.resize(count);
+		frames_left.assign(count, TrialSims::trial_frames);
+		frames_done.assign(count, 0);
+		{
+			ProfileScope scope(race_profile.enemy_setup_us);
+			for (const auto& job : round_jobs)
+			{
+				buildEnemySnapshots(job.second + 1);
+			}
+		}
+		for (int j = 0; j < count; ++j)
+		{
+			auto& sim = trials.sim(j);
+			Rng rng = enemy_rngs[round_jobs[j].second];
+			{
+				ProfileScope scope(race_profile.enemy_setup_us);
+				sim.clear();
+				sim.setUnitsPlayer2(enemy_snapshots[round_jobs[j].second]);
+			}
+			{
+				ProfileScope scope(race_profile.friendly_setup_us);
+				addContender(sim, *runners[round_jobs[j].first].contender, rng);
+			}
+#ifdef BRAWLSIM_PROFILE
+			units_at_start.resize(count);
+			units_at_start[j] = static_cast<int>(sim.getState().first->size() + sim.getState().second->size());
+#endif
+			trials.load(j);
+		}
+		round_running = true;
+		return true;
+	}
+
+	/// Simulate up to frames more frames of every trial in the round. Returns true once they are all over
+	bool Race::advanceRound(const int frames)
+	{
+		ProfileScope scope(race_profile.simulate_us);
+		pool.parallelFor(static_cast<int>(round_jobs.size()), [&](int j)
+		{
+			advanceTrial(j, frames);
+		});
+		return std::all_of(frames_left.begin(), frames_left.end(), [](int f) { return f == 0; });
+	}
+
+	/// Simulate up to frames more frames of trial j of the round
+	void Race::advanceTrial(const int j, const int frames)
+	{
+		if (frames_left[j] > 0)
+		{
+			const int n = std::min(frames, frames_left[j]);
+			const int simulated = trials.advance(j, n);
+			frames_done[j] += simulated;
+			frames_left[j] = simulated < n ? 0 : frames_left[j] - n;
+		}
+	}
+
+	/// Score the round's trials and drop the runners whose interval is entirely below the leader's
+	void Race::finishRound()
+	{
+		const SimBudget& budget = input.budget;
+		const int count = static_cast<int>(round_jobs.size());
+		{
+			ProfileScope scope(race_profile.scoring_us);
+			pool.parallelFor(count, [&](int j)
+			{
+				const RaceInput::Contender& contender = *runners[round_jobs[j].first].contender;
+				trials.store(j);
+				trial_scores[j] = postScore(trials.sim(j), contender.initial_score, contender.army_size);
+			});
+		}
+		sims_run += count;
+		frames_run += std::accumulate(frames_done.begin(), frames_done.end(), std::int64_t(0));
+		round_running = false;
+
+		race_profile.sims = sims_run;
+		race_profile.frames = frames_run;
+#ifdef BRAWLSIM_PROFILE
+		for (int j = 0; j < count; ++j)
+		{
+			const auto state = trials.sim(j).getState();
+			race_profile.units_killed += units_at_start[j] - static_cast<int>(state.first->size() + state.second->size());
+			race_profile.early_exits += frames_done[j] < TrialSims::trial_frames;
+		}
+#endif
+
+		for (int j = 0; j < count; ++j)
+		{
+			runners[round_jobs[j].first].stats.add(trial_scores[j]);
+		}
+
+		const int racing = dropTrailing();
+
+		done =
+			racing == 1 || // Every other runner is out
+			open_runners == 0 ||
+			(budget.microseconds > 0 && race_time >= budget.microseconds);
+		publishRanks();
+	}
+
+	/// Stop racing the runners whose scores are confidently below the leader's and return how many still race
+	int Race::dropTrailing()
+	{
+		const SimBudget& budget = input.budget;
+		const auto bound = [&](const Runner& runner, const double side)
+		{
+			return runner.stats.mean + side * budget.z * (runner.stats.count > 1 ? std::sqrt(runner.stats.variance() / runner.stats.count) : 0);
+		};
+		const Runner* leader = nullptr;
+		for (const auto& runner : runners)
+		{
+			if (runner.racing && (!leader || runner.stats.mean > leader->stats.mean))
+			{
+				leader = &runner;
+			}
+		}
+		int racing = 0;
+		open_runners = 0;
+		for (auto& runner : runners)
+		{
+			if (runner.racing && &runner != leader && runner.stats.count >= budget.min_sims && bound(runner, 1) < bound(*leader, -1))
+			{
+				runner.racing = false;
+			}
+			if (runner.racing)
+			{
+				++racing;
+				open_runners += runner.stats.count < budget.max_sims;
+			}
+		}
+		return racing;
+	}
+
+	/// Rank the unraced UnitTypes and the runners with trials so far in descending order.
+	/// Runners without a trial yet, when the budget ran out before they got one, are listed after them with 0 sims, then the pruned UnitTypes
+	void Race::publishRanks()
+	{
+		ProfileScope scope(race_profile.sorting_us);
+		unit_ranks = input.unraced_ranks;
+		for (const auto& runner : runners)
+		{
+			if (runner.stats.count > 0)
+			{
+				unit_ranks.push_back(UnitRank(runner.contender->prototype.data->type, runner.stats.mean, runner.stats.variance(), runner.stats.count));
+			}
+		}
+		sort(unit_ranks.begin(), unit_ranks.end(), [&](const UnitRank& lhs, const UnitRank& rhs)
+		{
+			return lhs.score > rhs.score;
+		});
+		const size_t ranked = unit_ranks.size();
+		for (const auto& runner : runners)
+		{
+			if (runner.stats.count == 0)
+			{
+				unit_ranks.push_back(UnitRank(runner.contender->prototype.data->type, 0));
+			}
+		}
+		unit_ranks.insert(unit_ranks.end(), input.pruned_ranks.begin(), input.pruned_ranks.end());
+		setOptimalUnit(ranked);
+	}
+
+	/// Set the optimal unit to the friendly UnitType with the highest score among the first ranked ranks. If scores are tied, chooses more "flexible" UnitType.
+	void Race::setOptimalUnit(const size_t ranked)
+	{
+		double best_sim_score = INT_MIN;
+		BWAPI::UnitType res = BWAPI::UnitTypes::None;
+
+		// ranks are sorted so just check scores that are equal to the first unit's score
+		for (size_t r = 0; r < ranked; ++r)
+		{
+			const UnitRank& u = unit_ranks[r];
+			// there are several cases where the test return ties, ex: cannot see enemy units and they appear "empty", extremely one-sided combat...
+			if (u.score > best_sim_score)
+			{
+				best_sim_score = u.score;
+				res = u.type;
+			}
+			// there are several cases where the t est return ties, ex: cannot see enemy units and they appear "empty", extremely one-sided combat...
+			else if (u.score == best_sim_score)
+			{
+				// if the current unit is "flexible" with regard to air and ground units, then keep it and continue to consider the next unit.
+				if (res.airWeapon() != BWAPI::WeaponTypes::None && res.groundWeapon() != BWAPI::WeaponTypes::None)
+				{
+					continue;
+				}
+				// if the tying unit is "flexible", then let's use that one.
+				else if (u.type.airWeapon() != BWAPI::WeaponTypes::None && u.type.groundWeapon() != BWAPI::WeaponTypes::None)
+				{
+					res = u.type;
+				}
+			}
+			// Scores are getting lower, return what we have
+			else
+			{
+				break;
+			}
+		}
+		optimal_unit = res;
+	}
+}
@@ -0,0 +1,80 @@
+#include "../../BrawlSimLib/include/BrawlSim/RaceBatch.hpp"
+
+namespace BrawlSim
+{
+	RaceBatch::RaceBatch(ThreadPool& thread_pool)
+		: pool(thread_pool)
+	{
+	}
+
+	void RaceBatch::resize(const int count)
+	{
+		while (static_cast<int>(races.size()) < count)
+		{
+			races.push_back(std::make_unique<Race>(pool));
+		}
+		race_count = count;
+		for (int i = 0; i < race_count; ++i)
+		{
+			races[i]->reset();
+		}
+	}
+
+	RaceInput& RaceBatch::prepare(const int i)
+	{
+		return races[i]->prepare();
+	}
+
+	/// Start every race, then run their rounds side by side until none has trials left
+	void RaceBatch::run()
+	{
+		for (int i = 0; i < race_count; ++i)
+		{
+			races[i]->start();
+		}
+
+		while (true)
+		{
+			jobs.clear();
+			round_races.clear();
+			for (int i = 0; i < race_count; ++i)
+			{
+				const int trials = races[i]->beginRound();
+				for (int j = 0; j < trials; ++j)
+				{
+					jobs.push_back(std::make_pair(i, j));
+				}
+				if (trials > 0)
+				{
+					round_races.push_back(i);
+				}
+			}
+			if (jobs.empty())
+			{
+				break;
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			pool.parallelFor(static_cast<int>(jobs.size()), [&](int k)
+			{
+				races[jobs[k].first]->runTrial(jobs[k].second);
+			});
+			const std::int64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+			for (const int i : round_races)
+			{
+				races[i]->endRound(microseconds);
+			}
+		}
+	}
+
+	const Race& RaceBatch::race(const int i) const
+	{
+		return *races[i];
+	}
+
+	int RaceBatch::size() const
+	{
+		return race_count;
+	}
+}
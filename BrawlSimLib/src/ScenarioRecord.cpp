@@ -0,0 +1,434 @@
+#include "../../BrawlSimLib/include/BrawlSim/ScenarioRecord.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BrawlSim
+{
+	namespace
+	{
+		/// File header: magic and format version
+		const char				file_magic[4] = { 'B', 'R', 'S', 'C' };
+		const std::uint32_t		file_version = 1;
+		const size_t			header_size = sizeof(file_magic) + sizeof(file_version);
+
+		/// Values are stored in the host's byte order, little-endian on every platform BWAPI runs on
+		template <typename T>
+		void put(std::vector<unsigned char>& bytes, const T value)
+		{
+			const size_t at = bytes.size();
+			bytes.resize(at + sizeof(T));
+			std::memcpy(&bytes[at], &value, sizeof(T));
+		}
+
+		/// Reads values off a record. Running past its end returns zeros and marks the record damaged
+		struct ByteReader
+		{
+			const unsigned char*	at;
+			const unsigned char*	end;
+			bool					ok = true;
+
+			template <typename T>
+			T get()
+			{
+				T value{};
+				if (static_cast<size_t>(end - at) < sizeof(T))
+				{
+					ok = false;
+					at = end;
+					return value;
+				}
+				std::memcpy(&value, at, sizeof(T));
+				at += sizeof(T);
+				return value;
+			}
+		};
+
+		void putTypes(std::vector<unsigned char>& bytes, const std::vector<BWAPI::UnitType>& types)
+		{
+			put<std::uint32_t>(bytes, static_cast<std::uint32_t>(types.size()));
+			for (const auto& type : types)
+			{
+				put<std::uint16_t>(bytes, static_cast<std::uint16_t>(type.getID()));
+			}
+		}
+
+		void getTypes(ByteReader& in, std::vector<BWAPI::UnitType>& types)
+		{
+			const std::uint32_t count = in.get<std::uint32_t>();
+			types.clear();
+			for (std::uint32_t i = 0; i < count && in.ok; ++i)
+			{
+				types.push_back(BWAPI::UnitType(in.get<std::uint16_t>()));
+			}
+		}
+
+		void putUnit(std::vector<unsigned char>& bytes, const FAP::FAPUnit<UnitTag>& unit)
+		{
+			put<std::int32_t>(bytes, unit.x);
+			put<std::int32_t>(bytes, unit.y);
+			put<std::int32_t>(bytes, unit.health);
+			put<std::int32_t>(bytes, unit.maxHealth);
+			put<std::int32_t>(bytes, unit.armor);
+			put<std::int32_t>(bytes, unit.shields);
+			put<std::int32_t>(bytes, unit.maxShields);
+			put<std::int32_t>(bytes, unit.shieldArmor);
+			put<float>(bytes, unit.speed);
+			put<float>(bytes, unit.speedSquared);
+			put<std::uint8_t>(bytes, unit.flying);
+			put<std::int32_t>(bytes, unit.elevation);
+			put<std::int32_t>(bytes, unit.groundDamage);
+			put<std::int32_t>(bytes, unit.groundCooldown);
+			put<std::int32_t>(bytes, unit.groundMaxRangeSquared);
+			put<std::int32_t>(bytes, unit.groundMinRangeSquared);
+			put<std::uint8_t>(bytes, static_cast<std::uint8_t>(unit.groundDamageType.getID()));
+			put<std::int32_t>(bytes, unit.airDamage);
+			put<std::int32_t>(bytes, unit.airCooldown);
+			put<std::int32_t>(bytes, unit.airMaxRangeSquared);
+			put<std::int32_t>(bytes, unit.airMinRangeSquared);
+			put<std::uint8_t>(bytes, static_cast<std::uint8_t>(unit.airDamageType.getID()));
+			put<std::uint16_t>(bytes, static_cast<std::uint16_t>(unit.unitType.getID()));
+			put<std::uint8_t>(bytes, static_cast<std::uint8_t>(unit.unitSize.getID()));
+			put<std::uint8_t>(bytes, unit.isOrganic);
+			put<std::int32_t>(bytes, unit.numAttackers);
+			put<std::int32_t>(bytes, unit.attackCooldownRemaining);
+		}
+
+		/// The unit's UnitTag is left empty, the record has no UnitData for it to point at
+		void getUnit(ByteReader& in, FAP::FAPUnit<UnitTag>& unit)
+		{
+			unit.x = in.get<std::int32_t>();
+			unit.y = in.get<std::int32_t>();
+			unit.health = in.get<std::int32_t>();
+			unit.maxHealth = in.get<std::int32_t>();
+			unit.armor = in.get<std::int32_t>();
+			unit.shields = in.get<std::int32_t>();
+			unit.maxShields = in.get<std::int32_t>();
+			unit.shieldArmor = in.get<std::int32_t>();
+			unit.speed = in.get<float>();
+			unit.speedSquared = in.get<float>();
+			unit.flying = in.get<std::uint8_t>() != 0;
+			unit.elevation = in.get<std::int32_t>();
+			unit.groundDamage = in.get<std::int32_t>();
+			unit.groundCooldown = in.get<std::int32_t>();
+			unit.groundMaxRangeSquared = in.get<std::int32_t>();
+			unit.groundMinRangeSquared = in.get<std::int32_t>();
+			unit.groundDamageType = BWAPI::DamageType(in.get<std::uint8_t>());
+			unit.airDamage = in.get<std::int32_t>();
+			unit.airCooldown = in.get<std::int32_t>();
+			unit.airMaxRangeSquared = in.get<std::int32_t>();
+			unit.airMinRangeSquared = in.get<std::int32_t>();
+			unit.airDamageType = BWAPI::DamageType(in.get<std::uint8_t>());
+			unit.unitType = BWAPI::UnitType(in.get<std::uint16_t>());
+			unit.unitSize = BWAPI::UnitSizeType(in.get<std::uint8_t>());
+			unit.isOrganic = in.get<std::uint8_t>() != 0;
+			unit.didHealThisFrame = false;
+			unit.numAttackers = in.get<std::int32_t>();
+			unit.attackCooldownRemaining = in.get<std::int32_t>();
+			unit.data = UnitTag();
+		}
+
+		void encode(const Scenario& scenario, std::vector<unsigned char>& bytes)
+		{
+			put<std::uint8_t>(bytes, static_cast<std::uint8_t>(scenario.kind));
+			put<std::uint64_t>(bytes, scenario.seed);
+			put<std::int32_t>(bytes, scenario.frame);
+			put<std::uint8_t>(bytes, static_cast<std::uint8_t>(scenario.engine));
+
+			put<std::int32_t>(bytes, scenario.budget.total_sims);
+			put<std::int64_t>(bytes, scenario.budget.microseconds);
+			put<std::int32_t>(bytes, scenario.budget.min_sims);
+			put<std::int32_t>(bytes, scenario.budget.max_sims);
+			put<double>(bytes, scenario.budget.z);
+			put<double>(bytes, scenario.budget.prune_below);
+			put<std::int32_t>(bytes, scenario.scoring_type);
+			put<std::int32_t>(bytes, scenario.army_size);
+			put<std::int32_t>(bytes, scenario.trials);
+
+			for (const auto& player : scenario.players)
+			{
+				put<std::uint8_t>(bytes, static_cast<std::uint8_t>(player.upgrades.size()));
+				for (const auto& upgrade : player.upgrades)
+				{
+					put<std::uint8_t>(bytes, static_cast<std::uint8_t>(upgrade.first));
+					put<std::uint8_t>(bytes, static_cast<std::uint8_t>(upgrade.second));
+				}
+				put<std::uint8_t>(bytes, static_cast<std::uint8_t>(player.techs.size()));
+				for (const int tech : player.techs)
+				{
+					put<std::uint8_t>(bytes, static_cast<std::uint8_t>(tech));
+				}
+			}
+
+			putTypes(bytes, scenario.friendly_types);
+			putTypes(bytes, scenario.enemy_types);
+
+			put<std::uint32_t>(bytes, static_cast<std::uint32_t>(scenario.prototypes.size()));
+			for (const auto& prototype : scenario.prototypes)
+			{
+				put<std::uint8_t>(bytes, static_cast<std::uint8_t>(prototype.side));
+				putUnit(bytes, prototype.unit);
+				put<std::int32_t>(bytes, prototype.eco_score);
+				put<double>(bytes, prototype.survival_rate);
+				put<double>(bytes, prototype.top_speed);
+			}
+
+			put<std::uint32_t>(bytes, static_cast<std::uint32_t>(scenario.ranks.size()));
+			for (const auto& rank : scenario.ranks)
+			{
+				put<std::uint16_t>(bytes, static_cast<std::uint16_t>(rank.type.getID()));
+				put<double>(bytes, rank.score);
+				put<double>(bytes, rank.variance);
+				put<std::int32_t>(bytes, rank.sims);
+			}
+			put<std::uint16_t>(bytes, static_cast<std::uint16_t>(scenario.optimal_unit.getID()));
+			put<std::int32_t>(bytes, scenario.friendly_score);
+			put<std::int32_t>(bytes, scenario.enemy_score);
+		}
+
+		bool decode(ByteReader in, Scenario& scenario)
+		{
+			scenario.clear();
+			scenario.kind = static_cast<Scenario::Kind>(in.get<std::uint8_t>());
+			scenario.seed = in.get<std::uint64_t>();
+			scenario.frame = in.get<std::int32_t>();
+			scenario.engine = static_cast<SimEngine>(in.get<std::uint8_t>());
+
+			scenario.budget.total_sims = in.get<std::int32_t>();
+			scenario.budget.microseconds = in.get<std::int64_t>();
+			scenario.budget.min_sims = in.get<std::int32_t>();
+			scenario.budget.max_sims = in.get<std::int32_t>();
+			scenario.budget.z = in.get<double>();
+			scenario.budget.prune_below = in.get<double>();
+			scenario.scoring_type = in.get<std::int32_t>();
+			scenario.army_size = in.get<std::int32_t>();
+			scenario.trials = in.get<std::int32_t>();
+
+			for (auto& player : scenario.players)
+			{
+				const int upgrades = in.get<std::uint8_t>();
+				for (int i = 0; i < upgrades && in.ok; ++i)
+				{
+					const int upgrade = in.get<std::uint8_t>();
+					player.upgrades.push_back(std::make_pair(upgrade, static_cast<int>(in.get<std::uint8_t>())));
+				}
+				const int techs = in.get<std::uint8_t>();
+				for (int i = 0; i < techs && in.ok; ++i)
+				{
+					player.techs.push_back(in.get<std::uint8_t>());
+				}
+			}
+
+			getTypes(in, scenario.friendly_types);
+			getTypes(in, scenario.enemy_types);
+
+			const std::uint32_t prototypes = in.get<std::uint32_t>();
+			for (std::uint32_t i = 0; i < prototypes && in.ok; ++i)
+			{
+				ScenarioPrototype prototype;
+				prototype.side = in.get<std::uint8_t>();
+				getUnit(in, prototype.unit);
+				prototype.eco_score = in.get<std::int32_t>();
+				prototype.survival_rate = in.get<double>();
+				prototype.top_speed = in.get<double>();
+				scenario.prototypes.push_back(prototype);
+			}
+
+			const std::uint32_t ranks = in.get<std::uint32_t>();
+			for (std::uint32_t i = 0; i < ranks && in.ok; ++i)
+			{
+				const BWAPI::UnitType type(in.get<std::uint16_t>());
+				const double score = in.get<double>();
+				const double variance = in.get<double>();
+				scenario.ranks.push_back(UnitRank(type, score, variance, in.get<std::int32_t>()));
+			}
+			scenario.optimal_unit = BWAPI::UnitType(in.get<std::uint16_t>());
+			scenario.friendly_score = in.get<std::int32_t>();
+			scenario.enemy_score = in.get<std::int32_t>();
+			return in.ok;
+		}
+	}
+
+	void Scenario::clear()
+	{
+		for (auto& player : players)
+		{
+			player.upgrades.clear();
+			player.techs.clear();
+		}
+		friendly_types.clear();
+		enemy_types.clear();
+		prototypes.clear();
+		ranks.clear();
+		optimal_unit = BWAPI::UnitTypes::None;
+		friendly_score = 0;
+		enemy_score = 0;
+	}
+
+	bool ScenarioWriter::open(const std::string& path)
+	{
+		close();
+		out.open(path, std::ios::binary | std::ios::trunc);
+		out.write(file_magic, sizeof(file_magic));
+		out.write(reinterpret_cast<const char*>(&file_version), sizeof(file_version));
+		return static_cast<bool>(out);
+	}
+
+	bool ScenarioWriter::isOpen() const
+	{
+		return out.is_open();
+	}
+
+	/// The record is built in memory first so its size can lead it
+	void ScenarioWriter::write(const Scenario& scenario)
+	{
+		if (!out.is_open())
+		{
+			return;
+		}
+		bytes.clear();
+		put<std::uint32_t>(bytes, 0);
+		encode(scenario, bytes);
+		const std::uint32_t size = static_cast<std::uint32_t>(bytes.size() - sizeof(std::uint32_t));
+		std::memcpy(bytes.data(), &size, sizeof(size));
+		out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	void ScenarioWriter::flush()
+	{
+		out.flush();
+	}
+
+	void ScenarioWriter::close()
+	{
+		if (out.is_open())
+		{
+			out.close();
+		}
+	}
+
+	ScenarioReader::~ScenarioReader()
+	{
+		close();
+	}
+
+	bool ScenarioReader::open(const std::string& path)
+	{
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER file_size;
+		HANDLE mapping = GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		file_handle = file;
+		mapping_handle = mapping;
+		if (!view)
+		{
+			close();
+			return false;
+		}
+		data = static_cast<const unsigned char*>(view);
+		length = static_cast<size_t>(file_size.QuadPart);
+#else
+		const int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+		struct stat file_stat;
+		void* view = fstat(file, &file_stat) == 0 && file_stat.st_size > 0 ? mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+		::close(file); // The mapping keeps the file open
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+		data = static_cast<const unsigned char*>(view);
+		length = static_cast<size_t>(file_stat.st_size);
+#endif
+
+		std::uint32_t version = 0;
+		if (length >= header_size)
+		{
+			std::memcpy(&version, data + sizeof(file_magic), sizeof(version));
+		}
+		if (length < header_size || std::memcmp(data, file_magic, sizeof(file_magic)) != 0 || version != file_version)
+		{
+			close();
+			return false;
+		}
+
+		// Index the complete records. A record cut short at the end of the file is left out
+		size_t at = header_size;
+		while (length - at >= sizeof(std::uint32_t))
+		{
+			std::uint32_t size;
+			std::memcpy(&size, data + at, sizeof(size));
+			if (length - at - sizeof(size) < size)
+			{
+				break;
+			}
+			offsets.push_back(at);
+			at += sizeof(size) + size;
+		}
+		return true;
+	}
+
+	void ScenarioReader::close()
+	{
+#ifdef _WIN32
+		if (data)
+		{
+			UnmapViewOfFile(data);
+		}
+		if (mapping_handle)
+		{
+			CloseHandle(static_cast<HANDLE>(mapping_handle));
+		}
+		if (file_handle)
+		{
+			CloseHandle(static_cast<HANDLE>(file_handle));
+		}
+#else
+		if (data)
+		{
+			munmap(const_cast<unsigned char*>(data), length);
+		}
+#endif
+		data = nullptr;
+		length = 0;
+		file_handle = nullptr;
+		mapping_handle = nullptr;
+		offsets.clear();
+	}
+
+	size_t ScenarioReader::size() const
+	{
+		return offsets.size();
+	}
+
+	bool ScenarioReader::read(const size_t i, Scenario& scenario) const
+	{
+		if (i >= offsets.size())
+		{
+			return false;
+		}
+		std::uint32_t size;
+		std::memcpy(&size, data + offsets[i], sizeof(size));
+		const unsigned char* record = data + offsets[i] + sizeof(size);
+		return decode({ record, record + size }, scenario);
+	}
+}
@@ -0,0 +1,100 @@
+#include "../../BrawlSimLib/include/BrawlSim/ThreadPool.hpp"
+
+namespace BrawlSim
+{
+	ThreadPool::ThreadPool(unsigned threads)
+	{
+		// The calling thread is one of the threads
+		for (unsigned i = 1; i < threads; ++i)
+		{
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (auto& w : workers)
+		{
+			w.join();
+		}
+	}
+
+	unsigned ThreadPool::size() const
+	{
+		return static_cast<unsigned>(workers.size()) + 1;
+	}
+
+	/// Hand out job indices and wait for every worker to check back in
+	void ThreadPool::run(const int count, const JobFunction job_fn, void* context)
+	{
+		if (count <= 0)
+		{
+			return;
+		}
+		// Not worth waking anyone up
+		if (workers.empty() || count == 1)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				job_fn(context, i);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = job_fn;
+			job_context = context;
+			job_count = count;
+			next_index = 0;
+			active = static_cast<unsigned>(workers.size());
+			++generation;
+		}
+		wake.notify_all();
+
+		runJobs();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this] { return active == 0; });
+		job = nullptr;
+		job_context = nullptr;
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		unsigned seen = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping)
+			{
+				return;
+			}
+			seen = generation;
+
+			lock.unlock();
+			runJobs();
+			lock.lock();
+
+			if (--active == 0)
+			{
+				finished.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::runJobs()
+	{
+		for (int i = next_index++; i < job_count; i = next_index++)
+		{
+			job(job_context, i);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#include "../../BrawlSimLib/include/BrawlSim/Timeline.hpp"
+
+#include <algorithm>
+
+namespace BrawlSim
+{
+	void Timeline::reset(const int new_capacity)
+	{
+		capacity = std::max(new_capacity, 1);
+		if (snapshots.size() < static_cast<size_t>(capacity))
+		{
+			snapshots.resize(capacity);
+		}
+		start = 0;
+		count = 0;
+		initial = TimelineFrame();
+		stopped_early = false;
+	}
+
+	/// The buffer is full once count reaches capacity, then start moves past the oldest snapshot
+	void Timeline::push(const TimelineFrame& snapshot)
+	{
+		if (count == 0)
+		{
+			initial = snapshot;
+		}
+		if (count < capacity)
+		{
+			snapshots[(start + count++) % capacity] = snapshot;
+		}
+		else
+		{
+			snapshots[start] = snapshot;
+			start = (start + 1) % capacity;
+		}
+	}
+
+	void Timeline::setStopped(const bool stopped)
+	{
+		stopped_early = stopped;
+	}
+
+	int Timeline::size() const
+	{
+		return count;
+	}
+
+	const TimelineFrame& Timeline::operator[](const int i) const
+	{
+		return snapshots[(start + i) % capacity];
+	}
+
+	const TimelineFrame& Timeline::first() const
+	{
+		return initial;
+	}
+
+	const TimelineFrame& Timeline::last() const
+	{
+		return count ? (*this)[count - 1] : initial;
+	}
+
+	bool Timeline::stoppedEarly() const
+	{
+		return stopped_early;
+	}
+
+	int Timeline::tippingFrame() const
+	{
+		const auto ahead = [this](const TimelineFrame& snapshot)
+		{
+			const double friendly = snapshot.friendly_health / static_cast<double>(std::max(initial.friendly_health, 1));
+			const double enemy = snapshot.enemy_health / static_cast<double>(std::max(initial.enemy_health, 1));
+			return (friendly > enemy) - (friendly < enemy);
+		};
+
+		const int side = ahead(last());
+		if (side == 0)
+		{
+			return initial.frame;
+		}
+
+		// Walk back from the end to the first snapshot of the final leader's run
+		int tip = last().frame;
+		for (int i = count - 1; i >= 0 && ahead((*this)[i]) == side; --i)
+		{
+			tip = (*this)[i].frame;
+		}
+		return tip;
+	}
+}
@@ -0,0 +1,138 @@
+#include "../../BrawlSimLib/include/BrawlSim/TrialSims.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace BrawlSim
+{
+	void TrialSims::configure(const SimEngine new_engine, const int grid_units)
+	{
+		engine = new_engine;
+		target_grid_units = grid_units;
+	}
+
+	void TrialSims::resize(const int trials)
+	{
+		if (sims.size() < static_cast<size_t>(trials))
+		{
+			sims.resize(trials);
+			soa_sims.resize(trials);
+		}
+	}
+
+	FAP::FastAPproximation<UnitTag>& TrialSims::sim(const int t)
+	{
+		return sims[t];
+	}
+
+	void TrialSims::load(const int t)
+	{
+		if (engine == SimEngine::ArrayOfStructs)
+		{
+			sims[t].setTargetGrid(target_grid_units);
+		}
+		else
+		{
+			soa_sims[t].setUnitsPlayer1(*sims[t].getState().first);
+			soa_sims[t].setUnitsPlayer2(*sims[t].getState().second);
+		}
+	}
+
+	int TrialSims::advance(const int t, const int frames)
+	{
+		if (engine == SimEngine::ArrayOfStructs)
+		{
+			return sims[t].simulate(frames);
+		}
+
+		const int done = soa_sims[t].simulate(frames);
+#ifdef BRAWLSIM_VERIFY_ENGINES
+		// Differential check of the two backends on real game data
+		const int verify_done = sims[t].simulate(frames);
+		const auto state = soa_sims[t].getState();
+		assert(done == verify_done && FAP::sameUnits(*sims[t].getState().first, *state.first) && FAP::sameUnits(*sims[t].getState().second, *state.second));
+#endif
+		return done;
+	}
+
+	void TrialSims::store(const int t)
+	{
+		if (engine == SimEngine::StructOfArrays)
+		{
+			const auto state = soa_sims[t].getState();
+			sims[t].setUnitsPlayer1(*state.first);
+			sims[t].setUnitsPlayer2(*state.second);
+		}
+	}
+
+	int TrialSims::simulate(const int t)
+	{
+		load(t);
+		const int frames = advance(t, trial_frames);
+		store(t);
+		return frames;
+	}
+
+	int TrialSims::simulate(const int t, const TimelineOptions& options, Timeline& timeline)
+	{
+		const int frames = options.frames > 0 ? options.frames : trial_frames;
+		const int interval = std::max(options.interval, 1);
+		load(t);
+
+		TimelineFrame current = snapshot(t, 0, TimelineFrame());
+		timeline.push(current);
+		bool stopped = options.stop && options.stop(current);
+
+		int done = 0;
+		while (!stopped && done < frames)
+		{
+			const int step = std::min(interval, frames - done);
+			const int ran = advance(t, step);
+			if (ran == 0)
+			{
+				break;
+			}
+			done += ran;
+			current = snapshot(t, done, timeline.first());
+			timeline.push(current);
+			if (ran < step)
+			{
+				break; // Combat is over
+			}
+			stopped = options.stop && options.stop(current);
+		}
+		timeline.setStopped(stopped);
+		store(t);
+		return done;
+	}
+
+	/// Read from the engine's totals, so the units aren't copied between steps. The first snapshot is taken with an empty initial
+	TimelineFrame TrialSims::snapshot(const int t, const int frame, const TimelineFrame& initial) const
+	{
+		FAP::PlayerTotals friendly;
+		FAP::PlayerTotals enemy;
+		if (engine == SimEngine::ArrayOfStructs)
+		{
+			friendly = sims[t].getTotals(1);
+			enemy = sims[t].getTotals(2);
+		}
+		else
+		{
+			friendly = soa_sims[t].getTotals(1);
+			enemy = soa_sims[t].getTotals(2);
+		}
+
+		TimelineFrame current;
+		current.frame = frame;
+		current.friendly_units = friendly.units;
+		current.enemy_units = enemy.units;
+		current.friendly_health = static_cast<int>((friendly.health + friendly.shields) >> 8);
+		current.enemy_health = static_cast<int>((enemy.health + enemy.shields) >> 8);
+		if (frame > 0)
+		{
+			current.friendly_damage = initial.enemy_health - current.enemy_health;
+			current.enemy_damage = initial.friendly_health - current.friendly_health;
+		}
+		return current;
+	}
+}
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Unit.hpp"
+#include "TargetGrid.hpp"
 #include "BWAPI.h"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace FAP {
@@ -12,6 +15,25 @@ namespace FAP {
     return v;
   }
 
+  /**
+   * \brief Checks that every value of the unit is set and returns the finished FAPUnit, so it can be kept and added to simulations later
+   * \param fu The Unit to finish
+   */
+  template<UnitValues uv, typename UnitExtension>
+  FAPUnit<UnitExtension> toFAPUnit(Unit<uv, UnitExtension> &&fu);
+
+  template<typename UnitExtension>
+  struct FastAPproximationSoA;
+
+  /**
+   * \brief What is left of a player's units. Health and shields are shifted left by 8 like the FAPUnit fields they sum
+   */
+  struct PlayerTotals {
+    int units = 0;
+    long long health = 0;
+    long long shields = 0;
+  };
+
   template<typename UnitExtension = std::tuple<>>
   struct FastAPproximation {
     /**
@@ -21,6 +43,12 @@ namespace FAP {
     template<UnitValues uv>
     [[deprecated]] void addUnitPlayer1(Unit<uv, UnitExtension> &&fu);
 
+    /**
+     * \brief Adds a finished unit to the simulator for player 1
+     * \param fu The FAPUnit to add, usually a copy of one made by toFAPUnit
+     */
+    void addUnitPlayer1(FAPUnit<UnitExtension> const &fu);
+
     /**
      * \brief Adds the unit to the simulator for player 1, only if it is a combat unit
      * \param fu The FAPUnit to add
@@ -33,6 +61,12 @@ namespace FAP {
      */
     template<UnitValues uv>
     [[deprecated]] void addUnitPlayer2(Unit<uv, UnitExtension> &&fu);
+
+    /**
+     * \brief Adds a finished unit to the simulator for player 2
+     * \param fu The FAPUnit to add, usually a copy of one made by toFAPUnit
+     */
+    void addUnitPlayer2(FAPUnit<UnitExtension> const &fu);
     /**
      * \brief Adds the unit to the simulator for player 2, only if it is a combat unit
      * \param fu The FAPUnit to add
@@ -40,12 +74,34 @@ namespace FAP {
     template<UnitValues uv>
     void addIfCombatUnitPlayer2(Unit<uv, UnitExtension> &&fu);
 
+    /**
+     * \brief Replaces player 1's units with a copy of units. Keeps the capacity of the simulator's vector
+     * \param units Finished FAPUnits, for example a snapshot shared by several simulations
+     */
+    void setUnitsPlayer1(std::vector<FAPUnit<UnitExtension>> const &units);
+
+    /**
+     * \brief Replaces player 2's units with a copy of units. Keeps the capacity of the simulator's vector
+     * \param units Finished FAPUnits, for example a snapshot shared by several simulations
+     */
+    void setUnitsPlayer2(std::vector<FAPUnit<UnitExtension>> const &units);
+
+    /**
+     * \brief Finds targets through a uniform grid over the enemy units instead of looking at all of them, once the enemy has at least minUnits units.
+     * Picks the same targets as the full scan, so it only changes the speed. Pays off in battles of a hundred or more units per side.
+     * \param minUnits Smallest number of enemy units that gets a grid. 0, the default, never uses one.
+     * \param cellSize Side of a grid cell in pixels
+     */
+    void setTargetGrid(int minUnits, int cellSize = 128);
+
     /**
      * \brief Starts the simulation. You can run this function multiple times. Feel free to run once, get the state and keep running.
      * \param nFrames the number of frames to simulate. A negative number runs the sim until combat is over.
+     * \return The number of frames in which a unit did something. Less than nFrames once combat is over,
+     * so a sim run in several calls can stop exactly where a single call would have.
      */
     template<bool tankSplash = false>
-    void simulate(int nFrames = 96); // = 24*4, 4 seconds on fastest
+    int simulate(int nFrames = 96); // = 24*4, 4 seconds on fastest
 
     /**
      * \brief Gets the internal state of the simulator. You can use this to get any info about the unit participating in the simulation or edit the state.
@@ -53,15 +109,37 @@ namespace FAP {
      */
     std::pair<std::vector<FAPUnit<UnitExtension>> *, std::vector<FAPUnit<UnitExtension>> *> getState();
 
+    /**
+     * \brief Sums a player's units without copying them, to watch a simulation between simulate calls.
+     * \param player 1 or 2
+     */
+    PlayerTotals getTotals(int player) const;
+
     /**
      * \brief Clears the simulation. All units are removed for both players. Equivalent to reconstructing.
      */
     void clear();
 
   private:
+    // Shares the unit rules (damage, deaths) so both layouts simulate identically
+    template<typename Extension>
+    friend struct FastAPproximationSoA;
+
     std::vector<FAPUnit<UnitExtension>> player1, player2;
 
     bool didSomething = false;
+
+    TargetGrid enemyGrid;
+    bool gridActive = false;
+    int gridMinUnits = 0;
+    int gridCellSize = 128;
+    std::vector<int> splashTargets;
+
+    void buildGrid(std::vector<FAPUnit<UnitExtension>> const &enemyUnits);
+    void killEnemy(std::vector<FAPUnit<UnitExtension>> &enemyUnits, int i);
+    int gridSplash(FAPUnit<UnitExtension> const &fu, std::vector<FAPUnit<UnitExtension>> &enemyUnits, int target,
+      int innerSquared, int medianSquared, int outerSquared);
+
     static void dealDamage(FAPUnit<UnitExtension> &fu, int damage, BWAPI::DamageType damageType);
     static int distSquared(FAPUnit<UnitExtension> const &u1, const FAPUnit<UnitExtension> &u2);
     static bool isSuicideUnit(BWAPI::UnitType ut);
@@ -76,6 +154,7 @@ namespace FAP {
     void isimulate();
 
     static void unitDeath(FAPUnit<UnitExtension> &&fu, std::vector<FAPUnit<UnitExtension>> &itsFriendlies);
+    static size_t spawnCapacity(std::vector<FAPUnit<UnitExtension>> const &units);
   
     static auto max(int a, int b) {
       int vars[2] = { a, b };
@@ -131,6 +210,12 @@ namespace FAP {
     return true;
   }
 
+  template<UnitValues uv, typename UnitExtension>
+  FAPUnit<UnitExtension> toFAPUnit(Unit<uv, UnitExtension> &&fu) {
+    static_assert(AssertValidUnit<uv>());
+    return fu.unit;
+  }
+
   template<typename UnitExtension>
   template<UnitValues uv>
   void FastAPproximation<UnitExtension>::addUnitPlayer1(Unit<uv, UnitExtension> &&fu) {
@@ -138,6 +223,11 @@ namespace FAP {
     player1.emplace_back(fu.unit);
   }
 
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::addUnitPlayer1(FAPUnit<UnitExtension> const &fu) {
+    player1.push_back(fu);
+  }
+
   template<typename UnitExtension>
   template<UnitValues uv>
   void FastAPproximation<UnitExtension>::addIfCombatUnitPlayer1(Unit<uv, UnitExtension> &&fu) {
@@ -152,6 +242,11 @@ namespace FAP {
     player2.emplace_back(fu.unit);
   }
 
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::addUnitPlayer2(FAPUnit<UnitExtension> const &fu) {
+    player2.push_back(fu);
+  }
+
   template<typename UnitExtension>
   template<UnitValues uv>
   void FastAPproximation<UnitExtension>::addIfCombatUnitPlayer2(Unit<uv, UnitExtension> &&fu) {
@@ -159,9 +254,30 @@ namespace FAP {
       addUnitPlayer2(std::move(fu));
   }
 
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::setUnitsPlayer1(std::vector<FAPUnit<UnitExtension>> const &units) {
+    player1.assign(units.begin(), units.end());
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::setUnitsPlayer2(std::vector<FAPUnit<UnitExtension>> const &units) {
+    player2.assign(units.begin(), units.end());
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::setTargetGrid(int const minUnits, int const cellSize) {
+    gridMinUnits = minUnits;
+    gridCellSize = cellSize;
+  }
+
   template<typename UnitExtension>
   template<bool tankSplash>
-  void FastAPproximation<UnitExtension>::simulate(int nFrames) {
+  int FastAPproximation<UnitExtension>::simulate(int nFrames) {
+    // Make room for the marines of dying Bunkers up front, so reused sims don't grow their vectors mid simulation
+    player1.reserve(spawnCapacity(player1));
+    player2.reserve(spawnCapacity(player2));
+
+    int frames = 0;
     while (nFrames--) {
       if (player1.empty() || player2.empty())
         break;
@@ -172,7 +288,9 @@ namespace FAP {
 
       if (!didSomething)
         break;
+      ++frames;
     }
+    return frames;
   }
 
   template<typename UnitExtension>
@@ -180,6 +298,17 @@ namespace FAP {
     return { &player1, &player2 };
   }
 
+  template<typename UnitExtension>
+  PlayerTotals FastAPproximation<UnitExtension>::getTotals(int const player) const {
+    PlayerTotals totals;
+    for (auto const &fu : player == 1 ? player1 : player2) {
+      ++totals.units;
+      totals.health += fu.health;
+      totals.shields += fu.shields;
+    }
+    return totals;
+  }
+
   template<typename UnitExtension>
   void FastAPproximation<UnitExtension>::clear() {
     player1.clear(), player2.clear();
@@ -247,24 +376,32 @@ namespace FAP {
     auto closestEnemy = enemyUnits.end();
     int closestDistSquared;
 
-    for (auto enemyIt = enemyUnits.begin(); enemyIt != enemyUnits.end(); ++enemyIt) {
-      if (enemyIt->flying) {
-        if (fu.airDamage) {
-          auto const d = distSquared(fu, *enemyIt);
-          if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
-            d >= fu.airMinRangeSquared) {
-            closestDistSquared = d;
-            closestEnemy = enemyIt;
+    if (gridActive) {
+      int const closest = enemyGrid.nearest({ fu.x, fu.y, fu.groundDamage != 0, fu.airDamage != 0, fu.groundMinRangeSquared, fu.airMinRangeSquared },
+        closestDistSquared);
+      if (closest != -1)
+        closestEnemy = enemyUnits.begin() + closest;
+    }
+    else {
+      for (auto enemyIt = enemyUnits.begin(); enemyIt != enemyUnits.end(); ++enemyIt) {
+        if (enemyIt->flying) {
+          if (fu.airDamage) {
+            auto const d = distSquared(fu, *enemyIt);
+            if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
+              d >= fu.airMinRangeSquared) {
+              closestDistSquared = d;
+              closestEnemy = enemyIt;
+            }
           }
         }
-      }
-      else {
-        if (fu.groundDamage) {
-          auto const d = distSquared(fu, *enemyIt);
-          if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
-            d >= fu.groundMinRangeSquared) {
-            closestDistSquared = d;
-            closestEnemy = enemyIt;
+        else {
+          if (fu.groundDamage) {
+            auto const d = distSquared(fu, *enemyIt);
+            if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
+              d >= fu.groundMinRangeSquared) {
+              closestDistSquared = d;
+              closestEnemy = enemyIt;
+            }
           }
         }
       }
@@ -297,36 +434,43 @@ namespace FAP {
             const int siegeTankBlastRadiusMedianSquared = siegeTankBlastRadiusMedian * siegeTankBlastRadiusMedian;
             const int siegeTankBlastRadiusOuterSquared = siegeTankBlastRadiusOuter * siegeTankBlastRadiusOuter;
 
-            for (auto enemyIt = enemyUnits.begin(); enemyIt != enemyUnits.end();) {
-              if (!enemyIt->flying && enemyIt != closestEnemy) {
-                bool killed = false;
-                auto const effectiveDistToClosestEnemySquared = distSquared(*closestEnemy, *enemyIt) / 4; // shell hit point to unit edge
-                auto underTaker = [&]() {
-                  if (enemyIt->health < 1) {
-                    killed = true;
-                    auto temp = *enemyIt;
-                    *enemyIt = enemyUnits.back();
-                    enemyUnits.pop_back();
-                    unitDeath(std::move(temp), enemyUnits);
+            if (gridActive) {
+              int const target = gridSplash(fu, enemyUnits, static_cast<int>(closestEnemy - enemyUnits.begin()),
+                siegeTankBlastRadiusInnerSquared, siegeTankBlastRadiusMedianSquared, siegeTankBlastRadiusOuterSquared);
+              closestEnemy = enemyUnits.begin() + target;
+            }
+            else {
+              for (auto enemyIt = enemyUnits.begin(); enemyIt != enemyUnits.end();) {
+                if (!enemyIt->flying && enemyIt != closestEnemy) {
+                  bool killed = false;
+                  auto const effectiveDistToClosestEnemySquared = distSquared(*closestEnemy, *enemyIt) / 4; // shell hit point to unit edge
+                  auto underTaker = [&]() {
+                    if (enemyIt->health < 1) {
+                      killed = true;
+                      auto temp = *enemyIt;
+                      *enemyIt = enemyUnits.back();
+                      enemyUnits.pop_back();
+                      unitDeath(std::move(temp), enemyUnits);
+                    }
+                    return;
+                  };
+
+                  if (effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusInnerSquared) { // inner
+                    dealDamage(*enemyIt, fu.groundDamage, fu.groundDamageType);
+                    underTaker();
                   }
-                  return;
-                };
-
-                if (effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusInnerSquared) { // inner
-                  dealDamage(*enemyIt, fu.groundDamage, fu.groundDamageType);
-                  underTaker();
-                }
-                else if (effectiveDistToClosestEnemySquared > siegeTankBlastRadiusInnerSquared && effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusMedianSquared) { // median
-                  dealDamage(*enemyIt, fu.groundDamage / 2, fu.groundDamageType);
-                  underTaker();
-                }
-                else if (effectiveDistToClosestEnemySquared > siegeTankBlastRadiusMedianSquared && effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusOuterSquared) { // outer
-                  dealDamage(*enemyIt, fu.groundDamage / 4, fu.groundDamageType);
-                  underTaker();
+                  else if (effectiveDistToClosestEnemySquared > siegeTankBlastRadiusInnerSquared && effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusMedianSquared) { // median
+                    dealDamage(*enemyIt, fu.groundDamage / 2, fu.groundDamageType);
+                    underTaker();
+                  }
+                  else if (effectiveDistToClosestEnemySquared > siegeTankBlastRadiusMedianSquared && effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusOuterSquared) { // outer
+                    dealDamage(*enemyIt, fu.groundDamage / 4, fu.groundDamageType);
+                    underTaker();
+                  }
+                  if (!killed) ++enemyIt;
                 }
-                if (!killed) ++enemyIt;
+                else ++enemyIt;
               }
-              else ++enemyIt;
             }
           }
         }
@@ -335,12 +479,8 @@ namespace FAP {
           fu.groundCooldown << static_cast<int>((fu.elevation != -1) & (closestEnemy->elevation != -1) & (closestEnemy->elevation > fu.elevation));
       }
 
-      if (closestEnemy->health < 1) {
-        auto temp = *closestEnemy;
-        *closestEnemy = enemyUnits.back();
-        enemyUnits.pop_back();
-        unitDeath(std::move(temp), enemyUnits);
-      }
+      if (closestEnemy->health < 1)
+        killEnemy(enemyUnits, static_cast<int>(closestEnemy - enemyUnits.begin()));
 
       didSomething = true;
     }
@@ -388,24 +528,32 @@ namespace FAP {
     auto closestEnemy = enemyUnits.end();
     int closestDistSquared;
 
-    for (auto enemyIt = enemyUnits.begin(); enemyIt != enemyUnits.end(); ++enemyIt) {
-      if (enemyIt->flying) {
-        if (fu.airDamage) {
-          auto const d = distSquared(fu, *enemyIt);
-          if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
-            d >= fu.airMinRangeSquared) {
-            closestDistSquared = d;
-            closestEnemy = enemyIt;
+    if (gridActive) {
+      int const closest = enemyGrid.nearest({ fu.x, fu.y, fu.groundDamage != 0, fu.airDamage != 0, fu.groundMinRangeSquared, fu.airMinRangeSquared },
+        closestDistSquared);
+      if (closest != -1)
+        closestEnemy = enemyUnits.begin() + closest;
+    }
+    else {
+      for (auto enemyIt = enemyUnits.begin(); enemyIt != enemyUnits.end(); ++enemyIt) {
+        if (enemyIt->flying) {
+          if (fu.airDamage) {
+            auto const d = distSquared(fu, *enemyIt);
+            if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
+              d >= fu.airMinRangeSquared) {
+              closestDistSquared = d;
+              closestEnemy = enemyIt;
+            }
           }
         }
-      }
-      else {
-        if (fu.groundDamage) {
-          int d = distSquared(fu, *enemyIt);
-          if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
-            d >= fu.groundMinRangeSquared) {
-            closestDistSquared = d;
-            closestEnemy = enemyIt;
+        else {
+          if (fu.groundDamage) {
+            int d = distSquared(fu, *enemyIt);
+            if ((closestEnemy == enemyUnits.end() || d < closestDistSquared) &&
+              d >= fu.groundMinRangeSquared) {
+              closestDistSquared = d;
+              closestEnemy = enemyIt;
+            }
           }
         }
       }
@@ -417,12 +565,8 @@ namespace FAP {
       else
         dealDamage(*closestEnemy, fu.groundDamage, fu.groundDamageType);
 
-      if (closestEnemy->health < 1) {
-        auto temp = *closestEnemy;
-        *closestEnemy = enemyUnits.back();
-        enemyUnits.pop_back();
-        unitDeath(std::move(temp), enemyUnits);
-      }
+      if (closestEnemy->health < 1)
+        killEnemy(enemyUnits, static_cast<int>(closestEnemy - enemyUnits.begin()));
 
       didSomething = true;
       return true;
@@ -459,13 +603,16 @@ namespace FAP {
       }
     };
 
+    buildGrid(player2);
     for (auto fu = player1.begin(); fu != player1.end();) {
       simUnit(fu, player1, player2);
     }
 
+    buildGrid(player1);
     for (auto fu = player2.begin(); fu != player2.end();) {
       simUnit(fu, player2, player1);
     }
+    gridActive = false;
 
     const auto updateUnit = [](FAPUnit<UnitExtension> &fu) {
       if (fu.attackCooldownRemaining)
@@ -498,6 +645,83 @@ namespace FAP {
       updateUnit(fu);
   }
 
+  // The enemies don't move while a player is simulated, so their grid is built once per player per frame
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::buildGrid(std::vector<FAPUnit<UnitExtension>> const &enemyUnits) {
+    gridActive = gridMinUnits > 0 && static_cast<int>(enemyUnits.size()) >= gridMinUnits;
+    if (gridActive)
+      enemyGrid.build(enemyUnits, gridCellSize);
+  }
+
+  // Swap and pop like everywhere else, keeping the grid in step with the enemy vector
+  template<typename UnitExtension>
+  void FastAPproximation<UnitExtension>::killEnemy(std::vector<FAPUnit<UnitExtension>> &enemyUnits, int const i) {
+    auto temp = enemyUnits[i];
+    enemyUnits[i] = enemyUnits.back();
+    enemyUnits.pop_back();
+    if (gridActive)
+      enemyGrid.swapPop(i);
+
+    auto const survivors = enemyUnits.size();
+    unitDeath(std::move(temp), enemyUnits);
+    for (auto j = survivors; gridActive && j < enemyUnits.size(); ++j)
+      gridActive = enemyGrid.push(enemyUnits[j].x, enemyUnits[j].y, enemyUnits[j].flying);
+  }
+
+  // Tank splash over the grid's nearby units. Visits them in the order of the linear loop in unitsim: by index, and a unit
+  // swapped into a dead unit's place is visited next. Follows the target if it is the unit that gets swapped. Returns the target's index
+  template<typename UnitExtension>
+  int FastAPproximation<UnitExtension>::gridSplash(FAPUnit<UnitExtension> const &fu, std::vector<FAPUnit<UnitExtension>> &enemyUnits, int target,
+    int const innerSquared, int const medianSquared, int const outerSquared) {
+    auto const splashed = [&](int const j) {
+      return j != target && !enemyUnits[j].flying && distSquared(enemyUnits[target], enemyUnits[j]) / 4 <= outerSquared;
+    };
+
+    // distSquared / 4 <= outer * outer means the distance is below 2 * outer + 1
+    splashTargets.clear();
+    enemyGrid.forEachNear(enemyUnits[target].x, enemyUnits[target].y, 2 * static_cast<int>(std::sqrt(outerSquared)) + 1, [&](int const j) {
+      if (splashed(j))
+        splashTargets.push_back(j);
+    });
+    std::sort(splashTargets.begin(), splashTargets.end());
+
+    for (size_t k = 0; k < splashTargets.size();) {
+      int const j = splashTargets[k];
+      auto const effectiveDistToClosestEnemySquared = distSquared(enemyUnits[target], enemyUnits[j]) / 4;
+
+      if (effectiveDistToClosestEnemySquared <= innerSquared)
+        dealDamage(enemyUnits[j], fu.groundDamage, fu.groundDamageType);
+      else if (effectiveDistToClosestEnemySquared <= medianSquared)
+        dealDamage(enemyUnits[j], fu.groundDamage / 2, fu.groundDamageType);
+      else
+        dealDamage(enemyUnits[j], fu.groundDamage / 4, fu.groundDamageType);
+
+      if (enemyUnits[j].health >= 1) {
+        ++k;
+        continue;
+      }
+
+      int const last = static_cast<int>(enemyUnits.size()) - 1;
+      bool const lastIsSplashed = last != j && splashTargets.back() == last;
+      if (target == last)
+        target = j;
+
+      killEnemy(enemyUnits, j);
+
+      if (lastIsSplashed)
+        splashTargets.pop_back();
+      else
+        ++k;
+
+      // Whatever the dead unit left behind (Bunker marines) is at the end and gets splashed too
+      for (int p = last; p < static_cast<int>(enemyUnits.size()); ++p)
+        if (splashed(p))
+          splashTargets.push_back(p);
+    }
+
+    return target;
+  }
+
   template<typename UnitExtension>
   void FastAPproximation<UnitExtension>::unitDeath(FAPUnit<UnitExtension> &&fu, std::vector<FAPUnit<UnitExtension>> &itsFriendlies) {
     if (fu.unitType == BWAPI::UnitTypes::Terran_Bunker && fu.numAttackers) {
@@ -534,4 +758,14 @@ namespace FAP {
     }
   }
 
+  // Most units the vector can hold once every Bunker in it has died and left its marines
+  template<typename UnitExtension>
+  size_t FastAPproximation<UnitExtension>::spawnCapacity(std::vector<FAPUnit<UnitExtension>> const &units) {
+    size_t capacity = units.size();
+    for (auto const &fu : units)
+      if (fu.unitType == BWAPI::UnitTypes::Terran_Bunker)
+        capacity += fu.numAttackers;
+    return capacity;
+  }
+
 } // namespace Neolib
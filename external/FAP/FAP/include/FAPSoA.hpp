@@ -0,0 +1,529 @@
+#pragma once
+
+#include "FAP.hpp"
+#include "NearestTarget.hpp"
+
+#include <climits>
+#include <vector>
+
+namespace FAP {
+  /**
+   * \brief FastAPproximation that stores each player's units as structure-of-arrays.
+   * The fields read for every unit by the target searches (position, health, shields, cooldown, flying) are kept in their own arrays.
+   * Everything else stays in a FAPUnit that is only touched for the acting unit and its target.
+   * Simulates exactly like FastAPproximation, unit order included.
+   */
+  template<typename UnitExtension = std::tuple<>>
+  struct FastAPproximationSoA {
+    /**
+     * \brief Adds a finished unit to the simulator for player 1
+     * \param fu The FAPUnit to add, usually a copy of one made by toFAPUnit
+     */
+    void addUnitPlayer1(FAPUnit<UnitExtension> const &fu);
+
+    /**
+     * \brief Adds a finished unit to the simulator for player 2
+     * \param fu The FAPUnit to add, usually a copy of one made by toFAPUnit
+     */
+    void addUnitPlayer2(FAPUnit<UnitExtension> const &fu);
+
+    /**
+     * \brief Replaces player 1's units with a copy of units. Keeps the capacity of the simulator's arrays
+     * \param units Finished FAPUnits, for example the state of a FastAPproximation
+     */
+    void setUnitsPlayer1(std::vector<FAPUnit<UnitExtension>> const &units);
+
+    /**
+     * \brief Replaces player 2's units with a copy of units. Keeps the capacity of the simulator's arrays
+     * \param units Finished FAPUnits, for example the state of a FastAPproximation
+     */
+    void setUnitsPlayer2(std::vector<FAPUnit<UnitExtension>> const &units);
+
+    /**
+     * \brief Starts the simulation. You can run this function multiple times. Feel free to run once, get the state and keep running.
+     * \param nFrames the number of frames to simulate. A negative number runs the sim until combat is over.
+     * \return The number of frames in which a unit did something. Less than nFrames once combat is over,
+     * so a sim run in several calls can stop exactly where a single call would have.
+     */
+    template<bool tankSplash = false>
+    int simulate(int nFrames = 96); // = 24*4, 4 seconds on fastest
+
+    /**
+     * \brief Gets a copy of the internal state of the simulator, in the same layout as FastAPproximation::getState.
+     * Edits to the vectors aren't seen by the simulator.
+     * \return Returns a pair of pointers, where each pointer points to a vector containing that player's units.
+     */
+    std::pair<std::vector<FAPUnit<UnitExtension>> *, std::vector<FAPUnit<UnitExtension>> *> getState();
+
+    /**
+     * \brief Sums a player's units from the hot arrays, without exporting the state like getState does.
+     * \param player 1 or 2
+     */
+    PlayerTotals getTotals(int player) const;
+
+    /**
+     * \brief Clears the simulation. All units are removed for both players. Equivalent to reconstructing.
+     */
+    void clear();
+
+  private:
+    struct Units {
+      std::vector<int> x, y;
+      std::vector<int> health, shields;
+      std::vector<int> attackCooldownRemaining;
+      std::vector<int> flying;
+      std::vector<FAPUnit<UnitExtension>> cold;
+
+      int size() const {
+        return static_cast<int>(cold.size());
+      }
+
+      void push(FAPUnit<UnitExtension> const &fu);
+      void clear();
+      void reserve(size_t n);
+      void assign(std::vector<FAPUnit<UnitExtension>> const &units);
+      void swapPop(int i);
+      void erase(int i);
+      FAPUnit<UnitExtension> get(int i) const;
+      void exportTo(std::vector<FAPUnit<UnitExtension>> &units) const;
+    };
+
+    using AoS = FastAPproximation<UnitExtension>;
+
+    Units player1, player2;
+    std::vector<FAPUnit<UnitExtension>> state1, state2, deathScratch;
+
+    bool didSomething = false;
+    static void dealDamage(Units &units, int i, int damage, BWAPI::DamageType damageType);
+    static int distSquared(Units const &a, int i, Units const &b, int j);
+    void killUnit(Units &units, int i);
+    int closestEnemy(Units const &friendly, int i, Units const &enemyUnits, int &closestDistSquared) const;
+
+    template<bool tankSplash>
+    void unitsim(Units &friendly, int i, Units &enemyUnits);
+
+    static void medicsim(Units &friendly, int i);
+    bool suicideSim(Units &friendly, int i, Units &enemyUnits);
+
+    template<bool tankSplash>
+    void isimulate();
+  };
+
+  /**
+   * \brief Checks that two unit vectors hold the same units in the same order, field by field
+   */
+  template<typename UnitExtension>
+  bool sameUnits(std::vector<FAPUnit<UnitExtension>> const &a, std::vector<FAPUnit<UnitExtension>> const &b) {
+    if (a.size() != b.size())
+      return false;
+
+    for (size_t i = 0; i < a.size(); ++i) {
+      auto const &u = a[i];
+      auto const &v = b[i];
+      if (u.x != v.x || u.y != v.y || u.health != v.health || u.maxHealth != v.maxHealth || u.armor != v.armor ||
+        u.shields != v.shields || u.maxShields != v.maxShields || u.shieldArmor != v.shieldArmor ||
+        u.speed != v.speed || u.speedSquared != v.speedSquared || u.flying != v.flying || u.elevation != v.elevation ||
+        u.groundDamage != v.groundDamage || u.groundCooldown != v.groundCooldown ||
+        u.groundMaxRangeSquared != v.groundMaxRangeSquared || u.groundMinRangeSquared != v.groundMinRangeSquared ||
+        u.groundDamageType != v.groundDamageType ||
+        u.airDamage != v.airDamage || u.airCooldown != v.airCooldown ||
+        u.airMaxRangeSquared != v.airMaxRangeSquared || u.airMinRangeSquared != v.airMinRangeSquared ||
+        u.airDamageType != v.airDamageType ||
+        u.unitType != v.unitType || u.unitSize != v.unitSize || u.isOrganic != v.isOrganic ||
+        u.didHealThisFrame != v.didHealThisFrame || u.numAttackers != v.numAttackers ||
+        u.attackCooldownRemaining != v.attackCooldownRemaining || !(u.data == v.data))
+        return false;
+    }
+    return true;
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::push(FAPUnit<UnitExtension> const &fu) {
+    x.push_back(fu.x);
+    y.push_back(fu.y);
+    health.push_back(fu.health);
+    shields.push_back(fu.shields);
+    attackCooldownRemaining.push_back(fu.attackCooldownRemaining);
+    flying.push_back(fu.flying);
+    cold.push_back(fu);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::clear() {
+    x.clear(), y.clear(), health.clear(), shields.clear(), attackCooldownRemaining.clear(), flying.clear(), cold.clear();
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::reserve(size_t const n) {
+    x.reserve(n), y.reserve(n), health.reserve(n), shields.reserve(n), attackCooldownRemaining.reserve(n), flying.reserve(n),
+      cold.reserve(n);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::assign(std::vector<FAPUnit<UnitExtension>> const &units) {
+    clear();
+    reserve(AoS::spawnCapacity(units));
+    for (auto const &fu : units)
+      push(fu);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::swapPop(int const i) {
+    auto const move = [i](auto &v) {
+      v[i] = v.back();
+      v.pop_back();
+    };
+    move(x), move(y), move(health), move(shields), move(attackCooldownRemaining), move(flying), move(cold);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::erase(int const i) {
+    auto const remove = [i](auto &v) {
+      v.erase(v.begin() + i);
+    };
+    remove(x), remove(y), remove(health), remove(shields), remove(attackCooldownRemaining), remove(flying), remove(cold);
+  }
+
+  template<typename UnitExtension>
+  FAPUnit<UnitExtension> FastAPproximationSoA<UnitExtension>::Units::get(int const i) const {
+    auto fu = cold[i];
+    fu.x = x[i];
+    fu.y = y[i];
+    fu.health = health[i];
+    fu.shields = shields[i];
+    fu.attackCooldownRemaining = attackCooldownRemaining[i];
+    fu.flying = flying[i] != 0;
+    return fu;
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::Units::exportTo(std::vector<FAPUnit<UnitExtension>> &units) const {
+    units.clear();
+    for (int i = 0; i < size(); ++i)
+      units.push_back(get(i));
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::addUnitPlayer1(FAPUnit<UnitExtension> const &fu) {
+    player1.push(fu);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::addUnitPlayer2(FAPUnit<UnitExtension> const &fu) {
+    player2.push(fu);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::setUnitsPlayer1(std::vector<FAPUnit<UnitExtension>> const &units) {
+    player1.assign(units);
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::setUnitsPlayer2(std::vector<FAPUnit<UnitExtension>> const &units) {
+    player2.assign(units);
+  }
+
+  template<typename UnitExtension>
+  template<bool tankSplash>
+  int FastAPproximationSoA<UnitExtension>::simulate(int nFrames) {
+    int frames = 0;
+    while (nFrames--) {
+      if (!player1.size() || !player2.size())
+        break;
+
+      didSomething = false;
+
+      isimulate<tankSplash>();
+
+      if (!didSomething)
+        break;
+      ++frames;
+    }
+    return frames;
+  }
+
+  template<typename UnitExtension>
+  std::pair<std::vector<FAPUnit<UnitExtension>> *, std::vector<FAPUnit<UnitExtension>> *> FastAPproximationSoA<UnitExtension>::getState() {
+    player1.exportTo(state1);
+    player2.exportTo(state2);
+    return { &state1, &state2 };
+  }
+
+  template<typename UnitExtension>
+  PlayerTotals FastAPproximationSoA<UnitExtension>::getTotals(int const player) const {
+    Units const &units = player == 1 ? player1 : player2;
+    PlayerTotals totals;
+    totals.units = units.size();
+    for (int i = 0; i < units.size(); ++i) {
+      totals.health += units.health[i];
+      totals.shields += units.shields[i];
+    }
+    return totals;
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::clear() {
+    player1.clear(), player2.clear();
+  }
+
+  // Same arithmetic as FastAPproximation::dealDamage, on the unit's synced cold copy
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::dealDamage(Units &units, int const i, int const damage, BWAPI::DamageType const damageType) {
+    auto &fu = units.cold[i];
+    fu.health = units.health[i];
+    fu.shields = units.shields[i];
+
+    AoS::dealDamage(fu, damage, damageType);
+
+    units.health[i] = fu.health;
+    units.shields[i] = fu.shields;
+  }
+
+  template<typename UnitExtension>
+  int FastAPproximationSoA<UnitExtension>::distSquared(Units const &a, int const i, Units const &b, int const j) {
+    return (a.x[i] - b.x[j]) * (a.x[i] - b.x[j]) + (a.y[i] - b.y[j]) * (a.y[i] - b.y[j]);
+  }
+
+  // Swap and pop like FastAPproximation, then let unitDeath add whatever the unit leaves behind (Bunker marines)
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::killUnit(Units &units, int const i) {
+    auto temp = units.get(i);
+    units.swapPop(i);
+
+    deathScratch.clear();
+    AoS::unitDeath(std::move(temp), deathScratch);
+    for (auto const &fu : deathScratch)
+      units.push(fu);
+  }
+
+  // Same pick as FastAPproximation::unitsim's scan, done by the vectorized kernel over the packed arrays
+  template<typename UnitExtension>
+  int FastAPproximationSoA<UnitExtension>::closestEnemy(Units const &friendly, int const i, Units const &enemyUnits, int &closestDistSquared) const {
+    auto const &fu = friendly.cold[i];
+    simd::TargetFilter const filter{ friendly.x[i], friendly.y[i], fu.groundDamage != 0, fu.airDamage != 0,
+      fu.groundMinRangeSquared, fu.airMinRangeSquared };
+
+    return simd::nearestTarget(enemyUnits.x.data(), enemyUnits.y.data(), enemyUnits.flying.data(), enemyUnits.size(),
+      filter, closestDistSquared);
+  }
+
+  template<typename UnitExtension>
+  template<bool tankSplash>
+  void FastAPproximationSoA<UnitExtension>::unitsim(Units &friendly, int const i, Units &enemyUnits) {
+    auto const &fu = friendly.cold[i];
+
+    if (friendly.attackCooldownRemaining[i]) {
+      didSomething = true;
+      return;
+    }
+
+    if (!(fu.groundDamage || fu.airDamage)) {
+      return;
+    }
+
+    int closestDistSquared;
+    int closest = closestEnemy(friendly, i, enemyUnits, closestDistSquared);
+
+    if (closest != -1 && closestDistSquared <= fu.speedSquared &&
+      !(friendly.x[i] == enemyUnits.x[closest] && friendly.y[i] == enemyUnits.y[closest])) {
+      friendly.x[i] = enemyUnits.x[closest];
+      friendly.y[i] = enemyUnits.y[closest];
+      closestDistSquared = 0;
+
+      didSomething = true;
+    }
+
+    if (closest != -1 &&
+      closestDistSquared <= (enemyUnits.flying[closest] ? fu.airMaxRangeSquared : fu.groundMaxRangeSquared)) {
+      if (enemyUnits.flying[closest]) {
+        dealDamage(enemyUnits, closest, fu.airDamage, fu.airDamageType);
+        friendly.attackCooldownRemaining[i] = fu.airCooldown;
+      }
+      else {
+        dealDamage(enemyUnits, closest, fu.groundDamage, fu.groundDamageType);
+
+        if constexpr (tankSplash) {
+          if (fu.unitType == BWAPI::UnitTypes::Terran_Siege_Tank_Siege_Mode) {
+            const int siegeTankBlastRadiusInner = fu.unitType.groundWeapon().innerSplashRadius();
+            const int siegeTankBlastRadiusMedian = fu.unitType.groundWeapon().medianSplashRadius();
+            const int siegeTankBlastRadiusOuter = fu.unitType.groundWeapon().outerSplashRadius();
+            const int siegeTankBlastRadiusInnerSquared = siegeTankBlastRadiusInner * siegeTankBlastRadiusInner;
+            const int siegeTankBlastRadiusMedianSquared = siegeTankBlastRadiusMedian * siegeTankBlastRadiusMedian;
+            const int siegeTankBlastRadiusOuterSquared = siegeTankBlastRadiusOuter * siegeTankBlastRadiusOuter;
+
+            for (int j = 0; j < enemyUnits.size();) {
+              if (!enemyUnits.flying[j] && j != closest) {
+                bool killed = false;
+                auto const effectiveDistToClosestEnemySquared = distSquared(enemyUnits, closest, enemyUnits, j) / 4; // shell hit point to unit edge
+                auto underTaker = [&]() {
+                  if (enemyUnits.health[j] < 1) {
+                    killed = true;
+                    // The target may be the unit swapped into j. FastAPproximation's iterator loses it here, keep following it
+                    bool const movesClosest = closest == enemyUnits.size() - 1;
+                    killUnit(enemyUnits, j);
+                    if (movesClosest)
+                      closest = j;
+                  }
+                };
+
+                if (effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusInnerSquared) { // inner
+                  dealDamage(enemyUnits, j, fu.groundDamage, fu.groundDamageType);
+                  underTaker();
+                }
+                else if (effectiveDistToClosestEnemySquared > siegeTankBlastRadiusInnerSquared && effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusMedianSquared) { // median
+                  dealDamage(enemyUnits, j, fu.groundDamage / 2, fu.groundDamageType);
+                  underTaker();
+                }
+                else if (effectiveDistToClosestEnemySquared > siegeTankBlastRadiusMedianSquared && effectiveDistToClosestEnemySquared <= siegeTankBlastRadiusOuterSquared) { // outer
+                  dealDamage(enemyUnits, j, fu.groundDamage / 4, fu.groundDamageType);
+                  underTaker();
+                }
+                if (!killed) ++j;
+              }
+              else ++j;
+            }
+          }
+        }
+
+        auto const &target = enemyUnits.cold[closest];
+        friendly.attackCooldownRemaining[i] =
+          fu.groundCooldown << static_cast<int>((fu.elevation != -1) & (target.elevation != -1) & (target.elevation > fu.elevation));
+      }
+
+      if (enemyUnits.health[closest] < 1)
+        killUnit(enemyUnits, closest);
+
+      didSomething = true;
+    }
+    else if (closest != -1 && closestDistSquared > fu.speedSquared && fu.speed >= 1.0f) {
+      auto const dx = enemyUnits.x[closest] - friendly.x[i];
+      auto const dy = enemyUnits.y[closest] - friendly.y[i];
+
+      friendly.x[i] += static_cast<int>(dx * (fu.speed / sqrt(dx * dx + dy * dy)));
+      friendly.y[i] += static_cast<int>(dy * (fu.speed / sqrt(dx * dx + dy * dy)));
+
+      didSomething = true;
+    }
+  }
+
+  template<typename UnitExtension>
+  void FastAPproximationSoA<UnitExtension>::medicsim(Units &friendly, int const i) {
+    int closestHealable = -1;
+    int closestDist = INT_MAX;
+
+    for (int j = 0; j < friendly.size(); ++j) {
+      auto const &it = friendly.cold[j];
+      if (it.isOrganic && friendly.health[j] < it.maxHealth && !it.didHealThisFrame) {
+        auto const d = distSquared(friendly, i, friendly, j);
+        if (d < closestDist) {
+          closestHealable = j;
+          closestDist = d;
+        }
+      }
+    }
+
+    if (closestHealable != -1) {
+      friendly.x[i] = friendly.x[closestHealable];
+      friendly.y[i] = friendly.y[closestHealable];
+
+      friendly.health[closestHealable] += 150;
+
+      if (friendly.health[closestHealable] > friendly.cold[closestHealable].maxHealth)
+        friendly.health[closestHealable] = friendly.cold[closestHealable].maxHealth;
+
+      friendly.cold[closestHealable].didHealThisFrame = true;
+    }
+  }
+
+  template<typename UnitExtension>
+  bool FastAPproximationSoA<UnitExtension>::suicideSim(Units &friendly, int const i, Units &enemyUnits) {
+    auto const &fu = friendly.cold[i];
+
+    int closestDistSquared;
+    int const closest = closestEnemy(friendly, i, enemyUnits, closestDistSquared);
+
+    if (closest != -1 && closestDistSquared <= fu.speedSquared) {
+      if (enemyUnits.flying[closest])
+        dealDamage(enemyUnits, closest, fu.airDamage, fu.airDamageType);
+      else
+        dealDamage(enemyUnits, closest, fu.groundDamage, fu.groundDamageType);
+
+      if (enemyUnits.health[closest] < 1)
+        killUnit(enemyUnits, closest);
+
+      didSomething = true;
+      return true;
+    }
+    else if (closest != -1 && closestDistSquared > fu.speedSquared) {
+      auto const dx = enemyUnits.x[closest] - friendly.x[i];
+      auto const dy = enemyUnits.y[closest] - friendly.y[i];
+
+      friendly.x[i] += static_cast<int>(dx * (fu.speed / sqrt(dx * dx + dy * dy)));
+      friendly.y[i] += static_cast<int>(dy * (fu.speed / sqrt(dx * dx + dy * dy)));
+
+      didSomething = true;
+    }
+
+    return false;
+  }
+
+  template<typename UnitExtension>
+  template<bool tankSplash>
+  void FastAPproximationSoA<UnitExtension>::isimulate() {
+    const auto simUnit = [this](int &i, Units &friendly, Units &enemy) {
+      if (AoS::isSuicideUnit(friendly.cold[i].unitType)) {
+        auto const unitDied = suicideSim(friendly, i, enemy);
+        if (unitDied)
+          friendly.erase(i);
+        else ++i;
+      }
+      else {
+        if (friendly.cold[i].unitType == BWAPI::UnitTypes::Terran_Medic)
+          medicsim(friendly, i);
+        else
+          unitsim<tankSplash>(friendly, i, enemy);
+        ++i;
+      }
+    };
+
+    for (int i = 0; i < player1.size();) {
+      simUnit(i, player1, player2);
+    }
+
+    for (int i = 0; i < player2.size();) {
+      simUnit(i, player2, player1);
+    }
+
+    const auto updateUnit = [](Units &units, int const i) {
+      auto &fu = units.cold[i];
+      if (units.attackCooldownRemaining[i])
+        --units.attackCooldownRemaining[i];
+      if (fu.didHealThisFrame)
+        fu.didHealThisFrame = false;
+
+      if (fu.unitType.getRace() == BWAPI::Races::Zerg) {
+        if (fu.unitType != BWAPI::UnitTypes::Zerg_Egg &&
+          fu.unitType != BWAPI::UnitTypes::Zerg_Lurker_Egg &&
+          fu.unitType != BWAPI::UnitTypes::Zerg_Larva) {
+          if (units.health[i] < fu.maxHealth)
+            units.health[i] += 4;
+          if (units.health[i] > fu.maxHealth)
+            units.health[i] = fu.maxHealth;
+        }
+      }
+      else if (fu.unitType.getRace() == BWAPI::Races::Protoss) {
+        if (units.shields[i] < fu.maxShields)
+          units.shields[i] += 7;
+        if (units.shields[i] > fu.maxShields)
+          units.shields[i] = fu.maxShields;
+      }
+    };
+
+    for (int i = 0; i < player1.size(); ++i)
+      updateUnit(player1, i);
+
+    for (int i = 0; i < player2.size(); ++i)
+      updateUnit(player2, i);
+  }
+
+} // namespace FAP
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <climits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FAP_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts any intrinsic anywhere, GCC and Clang need the instruction set enabled per function
+#if defined(FAP_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FAP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FAP_TARGET(isa)
+#endif
+
+namespace FAP {
+  namespace simd {
+    /**
+     * \brief What the searching unit can hit. A flying enemy is a valid target if air is set and it is at least
+     * airMinRangeSquared away, a ground enemy likewise.
+     */
+    struct TargetFilter {
+      int x, y;
+      bool ground, air;
+      int groundMinRangeSquared, airMinRangeSquared;
+    };
+
+    enum class Isa { Scalar, SSE41, AVX2 };
+
+    /**
+     * \brief Scalar search over [begin, n), continuing from a previous best. Ties keep the lowest index.
+     */
+    inline int nearestTargetScalar(int const *xs, int const *ys, int const *flying, int const begin, int const n,
+      TargetFilter const &f, int closest, int &closestDistSquared) {
+      for (int j = begin; j < n; ++j) {
+        if (flying[j] ? !f.air : !f.ground)
+          continue;
+
+        auto const d = (f.x - xs[j]) * (f.x - xs[j]) + (f.y - ys[j]) * (f.y - ys[j]);
+        if ((closest == -1 || d < closestDistSquared) &&
+          d >= (flying[j] ? f.airMinRangeSquared : f.groundMinRangeSquared)) {
+          closestDistSquared = d;
+          closest = j;
+        }
+      }
+
+      return closest;
+    }
+
+    // Every lane keeps its own best (distance, index). Lanes only see increasing indices, so the lowest
+    // (distance, index) pair over the lanes is the unit the scalar loop would have picked.
+    inline int reduceLanes(int const *ds, int const *js, int const lanes, int &closestDistSquared) {
+      int closest = -1;
+      for (int k = 0; k < lanes; ++k) {
+        if (js[k] == -1)
+          continue;
+        if (closest == -1 || ds[k] < closestDistSquared || (ds[k] == closestDistSquared && js[k] < closest)) {
+          closestDistSquared = ds[k];
+          closest = js[k];
+        }
+      }
+      return closest;
+    }
+
+#ifdef FAP_SIMD_X86
+    FAP_TARGET("sse4.1")
+    inline int nearestTargetSSE41(int const *xs, int const *ys, int const *flying, int const n, TargetFilter const &f,
+      int &closestDistSquared) {
+      __m128i const px = _mm_set1_epi32(f.x), py = _mm_set1_epi32(f.y);
+      __m128i const airMin = _mm_set1_epi32(f.airMinRangeSquared), groundMin = _mm_set1_epi32(f.groundMinRangeSquared);
+      __m128i const airOk = _mm_set1_epi32(f.air ? -1 : 0), groundOk = _mm_set1_epi32(f.ground ? -1 : 0);
+      __m128i const none = _mm_set1_epi32(-1), step = _mm_set1_epi32(4);
+
+      __m128i bestD = _mm_set1_epi32(INT_MAX), bestJ = none;
+      __m128i j = _mm_setr_epi32(0, 1, 2, 3);
+
+      int i = 0;
+      for (; i + 4 <= n; i += 4) {
+        __m128i const dx = _mm_sub_epi32(px, _mm_loadu_si128(reinterpret_cast<__m128i const *>(xs + i)));
+        __m128i const dy = _mm_sub_epi32(py, _mm_loadu_si128(reinterpret_cast<__m128i const *>(ys + i)));
+        __m128i const d = _mm_add_epi32(_mm_mullo_epi32(dx, dx), _mm_mullo_epi32(dy, dy));
+
+        __m128i const ground = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(flying + i)), _mm_setzero_si128());
+        __m128i const minRange = _mm_blendv_epi8(airMin, groundMin, ground);
+        __m128i const valid = _mm_andnot_si128(_mm_cmpgt_epi32(minRange, d), _mm_blendv_epi8(airOk, groundOk, ground));
+        __m128i const better = _mm_or_si128(_mm_cmpgt_epi32(bestD, d), _mm_cmpeq_epi32(bestJ, none));
+        __m128i const take = _mm_and_si128(valid, better);
+
+        bestD = _mm_blendv_epi8(bestD, d, take);
+        bestJ = _mm_blendv_epi8(bestJ, j, take);
+        j = _mm_add_epi32(j, step);
+      }
+
+      alignas(16) int ds[4], js[4];
+      _mm_store_si128(reinterpret_cast<__m128i *>(ds), bestD);
+      _mm_store_si128(reinterpret_cast<__m128i *>(js), bestJ);
+
+      int const closest = reduceLanes(ds, js, 4, closestDistSquared);
+      return nearestTargetScalar(xs, ys, flying, i, n, f, closest, closestDistSquared);
+    }
+
+    FAP_TARGET("avx2")
+    inline int nearestTargetAVX2(int const *xs, int const *ys, int const *flying, int const n, TargetFilter const &f,
+      int &closestDistSquared) {
+      __m256i const px = _mm256_set1_epi32(f.x), py = _mm256_set1_epi32(f.y);
+      __m256i const airMin = _mm256_set1_epi32(f.airMinRangeSquared), groundMin = _mm256_set1_epi32(f.groundMinRangeSquared);
+      __m256i const airOk = _mm256_set1_epi32(f.air ? -1 : 0), groundOk = _mm256_set1_epi32(f.ground ? -1 : 0);
+      __m256i const none = _mm256_set1_epi32(-1), step = _mm256_set1_epi32(8);
+
+      __m256i bestD = _mm256_set1_epi32(INT_MAX), bestJ = none;
+      __m256i j = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+      int i = 0;
+      for (; i + 8 <= n; i += 8) {
+        __m256i const dx = _mm256_sub_epi32(px, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(xs + i)));
+        __m256i const dy = _mm256_sub_epi32(py, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(ys + i)));
+        __m256i const d = _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+
+        __m256i const ground = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(flying + i)), _mm256_setzero_si256());
+        __m256i const minRange = _mm256_blendv_epi8(airMin, groundMin, ground);
+        __m256i const valid = _mm256_andnot_si256(_mm256_cmpgt_epi32(minRange, d), _mm256_blendv_epi8(airOk, groundOk, ground));
+        __m256i const better = _mm256_or_si256(_mm256_cmpgt_epi32(bestD, d), _mm256_cmpeq_epi32(bestJ, none));
+        __m256i const take = _mm256_and_si256(valid, better);
+
+        bestD = _mm256_blendv_epi8(bestD, d, take);
+        bestJ = _mm256_blendv_epi8(bestJ, j, take);
+        j = _mm256_add_epi32(j, step);
+      }
+
+      alignas(32) int ds[8], js[8];
+      _mm256_store_si256(reinterpret_cast<__m256i *>(ds), bestD);
+      _mm256_store_si256(reinterpret_cast<__m256i *>(js), bestJ);
+
+      int const closest = reduceLanes(ds, js, 8, closestDistSquared);
+      return nearestTargetScalar(xs, ys, flying, i, n, f, closest, closestDistSquared);
+    }
+#endif
+
+    inline Isa detectIsa() {
+#if defined(FAP_NO_SIMD) || !defined(FAP_SIMD_X86)
+      return Isa::Scalar;
+#elif defined(_MSC_VER)
+      int info[4];
+      __cpuid(info, 0);
+      int const maxLeaf = info[0];
+
+      __cpuid(info, 1);
+      bool const sse41 = (info[2] & (1 << 19)) != 0;
+      bool const osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+      bool avx2 = false;
+      if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+      }
+
+      return avx2 ? Isa::AVX2 : sse41 ? Isa::SSE41 : Isa::Scalar;
+#else
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        return Isa::AVX2;
+      if (__builtin_cpu_supports("sse4.1"))
+        return Isa::SSE41;
+      return Isa::Scalar;
+#endif
+    }
+
+    /**
+     * \brief The instruction set nearestTarget uses on this CPU. Detected once. Define FAP_NO_SIMD to always use the scalar loop.
+     */
+    inline Isa activeIsa() {
+      static Isa const isa = detectIsa();
+      return isa;
+    }
+
+    /**
+     * \brief Finds the closest valid target over packed position and flying arrays.
+     * Picks the same unit as a scalar scan in index order that only replaces the best on a strictly smaller distance.
+     * \param flying Nonzero for flying units
+     * \param closestDistSquared Set to the squared distance of the returned unit. Untouched if there is none.
+     * \return Index of the closest valid target, or -1
+     */
+    inline int nearestTarget(int const *xs, int const *ys, int const *flying, int const n, TargetFilter const &f,
+      int &closestDistSquared) {
+#ifdef FAP_SIMD_X86
+      switch (activeIsa()) {
+      case Isa::AVX2:
+        return nearestTargetAVX2(xs, ys, flying, n, f, closestDistSquared);
+      case Isa::SSE41:
+        return nearestTargetSSE41(xs, ys, flying, n, f, closestDistSquared);
+      default:
+        break;
+      }
+#endif
+      return nearestTargetScalar(xs, ys, flying, 0, n, f, -1, closestDistSquared);
+    }
+  } // namespace simd
+} // namespace FAP
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "Unit.hpp"
+#include "NearestTarget.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace FAP {
+  /**
+   * \brief Uniform grid over one player's units, used to find targets without looking at every unit.
+   * Positions are copied when the grid is built, so it is only valid while those units don't move. That holds for
+   * the enemies of the player being simulated. Indices follow the unit vector through swap and pop removals and push_backs.
+   */
+  struct TargetGrid {
+    /**
+     * \brief Rebuilds the grid over units
+     * \param cellSize Side of a cell in pixels
+     */
+    template<typename UnitExtension>
+    void build(std::vector<FAPUnit<UnitExtension>> const &units, int cellSize);
+
+    /**
+     * \brief Adds a unit at the next index. Returns false if it is outside the area the grid was built over,
+     * in which case the grid can't be used anymore.
+     */
+    bool push(int x, int y, bool flying);
+
+    /**
+     * \brief Removes unit i and moves the last unit to index i, like a swap and pop on the unit vector
+     */
+    void swapPop(int i);
+
+    /**
+     * \brief Same result as simd::nearestTarget over the units, ties going to the lowest index
+     * \return Index of the closest valid target, or -1. closestDistSquared is only set if there is one.
+     */
+    int nearest(simd::TargetFilter const &f, int &closestDistSquared) const;
+
+    /**
+     * \brief Calls f(i) for every unit whose cell overlaps the square of half-width reach around (x, y), in no particular order
+     */
+    template<typename Function>
+    void forEachNear(int x, int y, int reach, Function &&f) const;
+
+  private:
+    int cellSize = 1;
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    int cols = 0, rows = 0;
+    int groundCount = 0, airCount = 0;
+
+    std::vector<int> head;
+    std::vector<int> xs, ys, flying, cell, next, prev;
+
+    static int floorDiv(int const a, int const b) {
+      return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    int cellOf(int const x, int const y) const {
+      return (y - minY) / cellSize * cols + (x - minX) / cellSize;
+    }
+
+    void link(int i, int c);
+    void unlink(int i);
+  };
+
+  template<typename UnitExtension>
+  void TargetGrid::build(std::vector<FAPUnit<UnitExtension>> const &units, int const size) {
+    cellSize = std::max(1, size);
+    groundCount = airCount = 0;
+    xs.clear(), ys.clear(), flying.clear(), cell.clear(), next.clear(), prev.clear();
+
+    if (units.empty()) {
+      cols = rows = 0;
+      maxX = minX - 1;
+      head.clear();
+      return;
+    }
+
+    minX = maxX = units.front().x;
+    minY = maxY = units.front().y;
+    for (auto const &fu : units) {
+      minX = std::min(minX, fu.x), maxX = std::max(maxX, fu.x);
+      minY = std::min(minY, fu.y), maxY = std::max(maxY, fu.y);
+    }
+
+    cols = (maxX - minX) / cellSize + 1;
+    rows = (maxY - minY) / cellSize + 1;
+    head.assign(cols * rows, -1);
+
+    for (auto const &fu : units)
+      push(fu.x, fu.y, fu.flying);
+  }
+
+  inline bool TargetGrid::push(int const x, int const y, bool const isFlying) {
+    if (x < minX || x > maxX || y < minY || y > maxY)
+      return false;
+
+    int const i = static_cast<int>(xs.size());
+    xs.push_back(x), ys.push_back(y), flying.push_back(isFlying);
+    cell.push_back(0), next.push_back(-1), prev.push_back(-1);
+    link(i, cellOf(x, y));
+
+    ++(isFlying ? airCount : groundCount);
+    return true;
+  }
+
+  inline void TargetGrid::swapPop(int const i) {
+    --(flying[i] ? airCount : groundCount);
+    unlink(i);
+
+    int const last = static_cast<int>(xs.size()) - 1;
+    if (i != last) {
+      xs[i] = xs[last], ys[i] = ys[last], flying[i] = flying[last];
+      cell[i] = cell[last], next[i] = next[last], prev[i] = prev[last];
+
+      if (prev[i] != -1)
+        next[prev[i]] = i;
+      else
+        head[cell[i]] = i;
+      if (next[i] != -1)
+        prev[next[i]] = i;
+    }
+
+    xs.pop_back(), ys.pop_back(), flying.pop_back();
+    cell.pop_back(), next.pop_back(), prev.pop_back();
+  }
+
+  inline int TargetGrid::nearest(simd::TargetFilter const &f, int &closestDistSquared) const {
+    if (!(f.ground && groundCount) && !(f.air && airCount))
+      return -1;
+
+    int closest = -1;
+    auto const visit = [&](int const c) {
+      for (int j = head[c]; j != -1; j = next[j]) {
+        if (flying[j] ? !f.air : !f.ground)
+          continue;
+
+        auto const d = (f.x - xs[j]) * (f.x - xs[j]) + (f.y - ys[j]) * (f.y - ys[j]);
+        if (d < (flying[j] ? f.airMinRangeSquared : f.groundMinRangeSquared))
+          continue;
+
+        if (closest == -1 || d < closestDistSquared || (d == closestDistSquared && j < closest)) {
+          closestDistSquared = d;
+          closest = j;
+        }
+      }
+    };
+
+    // Rings of cells around the searching unit's cell, which may be outside the grid
+    int const qx = floorDiv(f.x - minX, cellSize);
+    int const qy = floorDiv(f.y - minY, cellSize);
+    int const firstRing = std::max({ 0, -qx, qx - (cols - 1), -qy, qy - (rows - 1) });
+    int const lastRing = std::max({ qx, cols - 1 - qx, qy, rows - 1 - qy });
+
+    for (int r = firstRing; r <= lastRing; ++r) {
+      // Units in ring r or further are at least (r - 1) * cellSize + 1 pixels away. Stop once none of them can win or tie
+      if (closest != -1 && r > 0) {
+        auto const bound = static_cast<long long>(r - 1) * cellSize + 1;
+        if (closestDistSquared < bound * bound)
+          break;
+      }
+
+      int const x0 = std::max(0, qx - r), x1 = std::min(cols - 1, qx + r);
+      int const y0 = std::max(0, qy - r), y1 = std::min(rows - 1, qy + r);
+
+      for (int const cy : { qy - r, qy + r }) {
+        if (cy >= 0 && cy < rows)
+          for (int cx = x0; cx <= x1; ++cx)
+            visit(cy * cols + cx);
+        if (!r)
+          break;
+      }
+
+      if (!r)
+        continue;
+
+      for (int const cx : { qx - r, qx + r }) {
+        if (cx >= 0 && cx < cols)
+          for (int cy = std::max(y0, qy - r + 1); cy <= std::min(y1, qy + r - 1); ++cy)
+            visit(cy * cols + cx);
+      }
+    }
+
+    return closest;
+  }
+
+  template<typename Function>
+  void TargetGrid::forEachNear(int const x, int const y, int const reach, Function &&f) const {
+    if (!cols)
+      return;
+
+    int const x0 = std::max(0, floorDiv(x - reach - minX, cellSize)), x1 = std::min(cols - 1, floorDiv(x + reach - minX, cellSize));
+    int const y0 = std::max(0, floorDiv(y - reach - minY, cellSize)), y1 = std::min(rows - 1, floorDiv(y + reach - minY, cellSize));
+
+    for (int cy = y0; cy <= y1; ++cy)
+      for (int cx = x0; cx <= x1; ++cx)
+        for (int j = head[cy * cols + cx]; j != -1; j = next[j])
+          f(j);
+  }
+
+  inline void TargetGrid::link(int const i, int const c) {
+    cell[i] = c;
+    prev[i] = -1;
+    next[i] = head[c];
+    if (head[c] != -1)
+      prev[head[c]] = i;
+    head[c] = i;
+  }
+
+  inline void TargetGrid::unlink(int const i) {
+    if (prev[i] != -1)
+      next[prev[i]] = next[i];
+    else
+      head[cell[i]] = next[i];
+    if (next[i] != -1)
+      prev[next[i]] = prev[i];
+  }
+} // namespace FAP
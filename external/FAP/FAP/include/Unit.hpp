@@ -395,6 +395,8 @@ namespace FAP {
 			friend struct FastAPproximation;
 			template<UnitValues uv>
 			friend constexpr bool AssertValidUnit();
+			template<UnitValues uv, typename Extension>
+			friend FAPUnit<Extension> toFAPUnit(Unit<uv, Extension> &&fu);
 			FAPUnit<UnitExtension> unit;
 
 			template<UnitValues bitToSet>